@@ -0,0 +1,171 @@
+#include "BlockFanOut.h"
+#include "../DebugLogger.h"
+
+BlockFanOut::BlockFanOut()
+{
+    // The calling thread takes lanes too, and the pool has the other cores
+    const int numHelpers = juce::jlimit(0, MAX_HELPERS, juce::SystemStats::getNumCpus() / 2 - 1);
+
+    RIPPLE_LOG(Init, Info, "Starting {} block fan-out helpers", numHelpers);
+
+    for (int i = 0; i < numHelpers; ++i)
+    {
+        auto helper = std::make_unique<Helper>(*this, i);
+        bool started = false;
+
+       #if RIPPLEATOR_REALTIME_WORKERS && JUCE_LINUX
+        started = helper->startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(9));
+        if (!started)
+            RIPPLE_LOG(Init, Warning, "Real-time scheduling unavailable for fan-out helper {}", i);
+       #endif
+
+        if (!started)
+            helper->startThread(juce::Thread::Priority::highest);
+
+        helpers.push_back(std::move(helper));
+    }
+}
+
+BlockFanOut::~BlockFanOut()
+{
+    for (auto& helper : helpers)
+    {
+        helper->signalThreadShouldExit();
+        helper->wakeUp.signal();
+    }
+
+    for (auto& helper : helpers)
+        helper->stopThread(1000);
+}
+
+void BlockFanOut::run(LaneFunction function, void* context, int numLanes)
+{
+    Slot* slot = nullptr;
+
+    if (numLanes > 1 && !helpers.empty())
+    {
+        for (auto& candidate : slots)
+        {
+            int expected = idle;
+            if (candidate.state.compare_exchange_strong(expected, filling))
+            {
+                slot = &candidate;
+                break;
+            }
+        }
+    }
+
+    // Nobody to share with, or every slot taken: run the lanes here
+    if (slot == nullptr)
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+            function(context, lane);
+
+        return;
+    }
+
+    slot->function = function;
+    slot->context = context;
+    slot->numLanes = numLanes;
+    slot->nextLane.store(0);
+    slot->lanesDone.store(0);
+    slot->state.store(running);
+
+    // Helpers still spinning from the last block find the job without this
+    const int numToWake = juce::jmin(numLanes - 1, static_cast<int>(helpers.size()));
+    for (int i = 0; i < numToWake; ++i)
+        helpers[static_cast<size_t>(i)]->wakeUp.signal();
+
+    // Take lanes like any helper; whatever a late helper has not claimed runs here
+    runLanes(*slot);
+
+    // Only lanes a helper has already started can still be running
+    for (int spin = 0; slot->lanesDone.load() < numLanes; ++spin)
+    {
+        if (spin >= SPIN_ITERATIONS)
+            juce::Thread::yield();
+    }
+
+    // Wait out helpers that looked at the slot, then hand it back
+    slot->state.store(closing);
+    while (slot->helpersInside.load() != 0)
+        juce::Thread::yield();
+
+    slot->state.store(idle);
+}
+
+void BlockFanOut::runLanes(Slot& slot)
+{
+    for (;;)
+    {
+        const int lane = slot.nextLane.fetch_add(1);
+        if (lane >= slot.numLanes)
+            return;
+
+        slot.function(slot.context, lane);
+        slot.lanesDone.fetch_add(1);
+    }
+}
+
+bool BlockFanOut::helpSomeone()
+{
+    bool helped = false;
+
+    for (auto& slot : slots)
+    {
+        if (slot.state.load() != running)
+            continue;
+
+        // The job's fields are only read while counted inside a running slot
+        slot.helpersInside.fetch_add(1);
+
+        if (slot.state.load() == running && slot.nextLane.load() < slot.numLanes)
+        {
+            runLanes(slot);
+            helped = true;
+        }
+
+        slot.helpersInside.fetch_sub(1);
+    }
+
+    return helped;
+}
+
+bool BlockFanOut::hasWork() const
+{
+    for (const auto& slot : slots)
+    {
+        if (slot.state.load() == running)
+            return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+BlockFanOut::Helper::Helper(BlockFanOut& ownerToUse, int index)
+    : juce::Thread("Rippleator Fan-out " + juce::String(index)),
+      owner(ownerToUse)
+{
+}
+
+void BlockFanOut::Helper::run()
+{
+    while (!threadShouldExit())
+    {
+        if (owner.helpSomeone())
+            continue;
+
+        // Another instance's block often follows right away; give up the
+        // core between looks rather than burn it
+        bool found = false;
+        for (int spin = 0; spin < SPIN_ITERATIONS && !found && !threadShouldExit(); ++spin)
+        {
+            juce::Thread::yield();
+            found = owner.hasWork();
+        }
+
+        if (!found)
+            wakeUp.wait(-1);
+    }
+}
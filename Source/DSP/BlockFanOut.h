@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#ifndef RIPPLEATOR_REALTIME_WORKERS
+ #define RIPPLEATOR_REALTIME_WORKERS 0     // 1 = helpers ask for real-time scheduling (Linux)
+#endif
+
+/**
+ * Splits the work of one audio block into lanes (e.g. one per microphone)
+ * and runs them on helper threads within the same callback.
+ *
+ * The helpers are process-wide, shared by every instance through a
+ * juce::SharedResourcePointer, and serve up to MAX_JOBS concurrent callers
+ * (hosts may process instances in parallel). A caller publishes its job in
+ * a free slot, wakes the helpers and then claims lanes itself like any
+ * helper, so lanes a late helper has not picked up are simply run on the
+ * calling thread; it only ever waits for lanes already in progress. Helpers
+ * look for another job a few times, yielding in between, before blocking,
+ * so instances processed back to back can share one wake-up.
+ *
+ * run() never allocates or takes a lock (waking a helper may briefly).
+ * With RIPPLEATOR_REALTIME_WORKERS the helpers use real-time scheduling on
+ * Linux.
+ */
+class BlockFanOut
+{
+public:
+    using LaneFunction = void (*)(void* context, int lane);
+
+    static constexpr int MAX_JOBS = 16;
+    static constexpr int MAX_HELPERS = 4;
+    static constexpr int SPIN_ITERATIONS = 64;
+
+    BlockFanOut();
+    ~BlockFanOut();
+
+    /**
+     * Call function(context, lane) once for every lane in 0..numLanes-1 and
+     * return when all have finished. Lanes may run concurrently, in any order.
+     */
+    void run(LaneFunction function, void* context, int numLanes);
+
+    int getNumHelpers() const noexcept { return static_cast<int>(helpers.size()); }
+
+private:
+    enum SlotState { idle, filling, running, closing };
+
+    /** One caller's job, on its own cache lines. */
+    struct alignas(64) Slot
+    {
+        std::atomic<int> state { idle };
+        std::atomic<int> helpersInside { 0 };
+        std::atomic<int> nextLane { 0 };
+        std::atomic<int> lanesDone { 0 };
+        LaneFunction function = nullptr;
+        void* context = nullptr;
+        int numLanes = 0;
+    };
+
+    class Helper : public juce::Thread
+    {
+    public:
+        Helper(BlockFanOut& owner, int index);
+        void run() override;
+
+        juce::WaitableEvent wakeUp;
+
+    private:
+        BlockFanOut& owner;
+    };
+
+    static void runLanes(Slot& slot);
+    bool helpSomeone();
+    bool hasWork() const;
+
+    std::array<Slot, MAX_JOBS> slots;
+    std::vector<std::unique_ptr<Helper>> helpers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BlockFanOut)
+};
@@ -0,0 +1,122 @@
+#include "BlockPipeline.h"
+#include "../Utils/AllocationGuard.h"
+
+BlockPipeline::BlockPipeline()
+    : juce::Thread("Rippleator DSP Pipeline")
+{
+}
+
+BlockPipeline::~BlockPipeline()
+{
+    release();
+}
+
+void BlockPipeline::prepare(int numChannels, int newBlockSize, Kernel newKernel)
+{
+    release();
+
+    blockSize = juce::jmax(1, newBlockSize);
+    kernel = std::move(newKernel);
+
+    for (auto& buffer : buffers)
+    {
+        buffer.setSize(numChannels, blockSize);
+        buffer.clear();
+    }
+
+    filling = 0;
+    position = 0;
+
+    // The host is waiting on every block, so the thread runs at its priority
+    startThread(juce::Thread::Priority::highest);
+}
+
+void BlockPipeline::release()
+{
+    signalThreadShouldExit();
+    jobReady.signal();
+    stopThread(2000);
+
+    jobBuffer.store(-1);
+    blockSize = 0;
+    kernel = nullptr;
+
+    for (auto& buffer : buffers)
+        buffer.setSize(0, 0);
+}
+
+void BlockPipeline::process(const juce::dsp::AudioBlock<float>& block)
+{
+    const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), buffers[0].getNumChannels());
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    for (int done = 0; done < numSamples;)
+    {
+        // The output of this block is the job dispatched at the last boundary
+        if (position == 0)
+            waitForJob();
+
+        auto& input = buffers[static_cast<size_t>(filling)];
+        const auto& output = buffers[static_cast<size_t>(1 - filling)];
+        const auto count = juce::jmin(blockSize - position, numSamples - done);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* host = block.getChannelPointer(static_cast<size_t>(channel)) + done;
+            juce::FloatVectorOperations::copy(input.getWritePointer(channel, position), host, count);
+            juce::FloatVectorOperations::copy(host, output.getReadPointer(channel, position), count);
+        }
+
+        position += count;
+        done += count;
+
+        if (position == blockSize)
+        {
+            dispatch(filling);
+            filling = 1 - filling;
+            position = 0;
+        }
+    }
+}
+
+void BlockPipeline::dispatch(int bufferIndex)
+{
+    jobBuffer.store(bufferIndex, std::memory_order_release);
+    jobReady.signal();
+}
+
+void BlockPipeline::waitForJob()
+{
+    for (int spin = 0; spin < SPIN_ITERATIONS; ++spin)
+    {
+        if (jobBuffer.load(std::memory_order_acquire) < 0)
+            return;
+    }
+
+    // A stale signal only means another look at the flag
+    while (jobBuffer.load(std::memory_order_acquire) >= 0)
+        jobDone.wait(1);
+}
+
+void BlockPipeline::run()
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    // Pipelined processing is held to the audio thread's rules
+    ScopedAllocationGuard allocationGuard;
+
+    while (!threadShouldExit())
+    {
+        jobReady.wait(-1);
+
+        const auto index = jobBuffer.load(std::memory_order_acquire);
+        if (index < 0 || threadShouldExit())
+            continue;
+
+        auto& buffer = buffers[static_cast<size_t>(index)];
+        kernel(juce::dsp::AudioBlock<float>(buffer));
+
+        jobBuffer.store(-1, std::memory_order_release);
+        jobDone.signal();
+    }
+}
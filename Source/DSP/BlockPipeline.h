@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <functional>
+
+/**
+ * Runs a block kernel on a dedicated thread, one block behind the caller.
+ *
+ * process() streams the host audio through two block buffers: while one
+ * collects the input of the current block and plays out the output of the
+ * previous one, the other is being processed on the pipeline thread. The
+ * audio thread therefore only copies samples and the kernel overlaps with
+ * whatever else the host does, at the cost of exactly one block of latency,
+ * which the owner reports to the host.
+ *
+ * When a block boundary falls mid-callback (hosts with irregular block
+ * sizes) or the kernel overruns, process() waits for the block it needs,
+ * spinning briefly before blocking, so the output is always complete.
+ */
+class BlockPipeline : private juce::Thread
+{
+public:
+    /** Processes one block in place on the pipeline thread. */
+    using Kernel = std::function<void(const juce::dsp::AudioBlock<float>&)>;
+
+    static constexpr int SPIN_ITERATIONS = 2000;
+
+    BlockPipeline();
+    ~BlockPipeline() override;
+
+    /**
+     * Allocate the buffers and start the thread. Not real-time safe.
+     * @param numChannels Number of channels passed through process()
+     * @param blockSize   Samples per pipelined block; also the added latency
+     * @param kernel      Called on the pipeline thread with each full block
+     */
+    void prepare(int numChannels, int blockSize, Kernel kernel);
+
+    /** Stop the thread and free the buffers. Not real-time safe. */
+    void release();
+
+    bool isPrepared() const noexcept { return blockSize > 0; }
+
+    int getLatencySamples() const noexcept { return blockSize; }
+
+    /**
+     * Pass a host block through the pipeline in place.
+     * @param block Host channels: read as input, overwritten with the delayed output
+     */
+    void process(const juce::dsp::AudioBlock<float>& block);
+
+private:
+    void run() override;
+    void dispatch(int bufferIndex);
+    void waitForJob();
+
+    std::array<juce::AudioBuffer<float>, 2> buffers;
+    int blockSize = 0;
+    int filling = 0;
+    int position = 0;
+
+    Kernel kernel;
+    std::atomic<int> jobBuffer { -1 };     // buffer being processed, or -1
+    juce::WaitableEvent jobReady;
+    juce::WaitableEvent jobDone;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BlockPipeline)
+};
@@ -0,0 +1,170 @@
+#include "ChamberFilterBank.h"
+
+void ChamberFilterBank::prepare(double sampleRate)
+{
+    smoothingSteps = juce::jmax(1, juce::roundToInt(sampleRate * SMOOTHING_SECONDS));
+
+    for (auto& micBands : bands)
+    {
+        for (auto& band : micBands)
+        {
+            band.z1.fill(0.0);
+            band.z2.fill(0.0);
+        }
+    }
+
+    for (auto& gain : gains)
+    {
+        gain.current = gain.target;
+        gain.remainingSteps = 0;
+    }
+}
+
+void ChamberFilterBank::setCoefficients(int chamber, int mic, const MicFrequencyBands& response) noexcept
+{
+    jassert(chamber >= 0 && chamber < MAX_CHAMBERS);
+    const auto lane = static_cast<size_t>(chamber);
+
+    for (int band = 0; band < NUM_BANDS; ++band)
+    {
+        const auto& source = response.bands[static_cast<size_t>(band)].biquad;
+        auto& destination = bands[static_cast<size_t>(mic)][static_cast<size_t>(band)];
+
+        destination.b0[lane] = source.b0;
+        destination.b1[lane] = source.b1;
+        destination.b2[lane] = source.b2;
+        destination.a1[lane] = source.a1;
+        destination.a2[lane] = source.a2;
+    }
+}
+
+void ChamberFilterBank::resetChamber(int chamber) noexcept
+{
+    jassert(chamber >= 0 && chamber < MAX_CHAMBERS);
+    const auto lane = static_cast<size_t>(chamber);
+
+    for (auto& micBands : bands)
+    {
+        for (auto& band : micBands)
+        {
+            band.z1[lane] = 0.0;
+            band.z2[lane] = 0.0;
+        }
+    }
+}
+
+void ChamberFilterBank::setTargetGain(int mic, float gain) noexcept
+{
+    auto& micGain = gains[static_cast<size_t>(mic)];
+
+    if (gain == micGain.target)
+        return;
+
+    micGain.target = gain;
+    micGain.remainingSteps = smoothingSteps;
+    micGain.step = (micGain.target - micGain.current) / static_cast<float>(smoothingSteps);
+}
+
+void ChamberFilterBank::mixMicrophones(const float* const* mics, float* output, int numSamples) const noexcept
+{
+    juce::FloatVectorOperations::clear(output, numSamples);
+
+    for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+    {
+        const auto& gain = gains[static_cast<size_t>(mic)];
+        const int rampLength = juce::jmin(numSamples, gain.remainingSteps);
+
+        // The same per-sample gains process() applies to this block
+        for (int i = 0; i < rampLength; ++i)
+            output[i] += mics[mic][i] * (gain.current + gain.step * static_cast<float>(i + 1));
+
+        juce::FloatVectorOperations::addWithMultiply(output + rampLength, mics[mic] + rampLength, gain.target, numSamples - rampLength);
+    }
+}
+
+void ChamberFilterBank::process(float* const* channels, int numChambers, int numSamples) noexcept
+{
+    jassert(numChambers <= MAX_CHAMBERS);
+    numChambers = juce::jmin(numChambers, MAX_CHAMBERS);
+
+    for (int first = 0; first < numChambers; first += LANE_WIDTH)
+    {
+        const auto offset = static_cast<size_t>(first);
+        const int numLanes = juce::jmin(LANE_WIDTH, numChambers - first);
+
+        // This register's coefficients and state stay in locals for the whole block
+        Lanes b0[NUM_MICROPHONES][NUM_BANDS], b1[NUM_MICROPHONES][NUM_BANDS], b2[NUM_MICROPHONES][NUM_BANDS];
+        Lanes a1[NUM_MICROPHONES][NUM_BANDS], a2[NUM_MICROPHONES][NUM_BANDS];
+        Lanes z1[NUM_MICROPHONES][NUM_BANDS], z2[NUM_MICROPHONES][NUM_BANDS];
+
+        for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+        {
+            for (int band = 0; band < NUM_BANDS; ++band)
+            {
+                const auto& source = bands[static_cast<size_t>(mic)][static_cast<size_t>(band)];
+                b0[mic][band] = Lanes::fromRawArray(source.b0.data() + offset);
+                b1[mic][band] = Lanes::fromRawArray(source.b1.data() + offset);
+                b2[mic][band] = Lanes::fromRawArray(source.b2.data() + offset);
+                a1[mic][band] = Lanes::fromRawArray(source.a1.data() + offset);
+                a2[mic][band] = Lanes::fromRawArray(source.a2.data() + offset);
+                z1[mic][band] = Lanes::fromRawArray(source.z1.data() + offset);
+                z2[mic][band] = Lanes::fromRawArray(source.z2.data() + offset);
+            }
+        }
+
+        // Unused lanes of the last register filter silence
+        alignas(64) double frame[LANE_WIDTH] = {};
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+                frame[lane] = channels[first + lane][i];
+
+            const auto input = Lanes::fromRawArray(frame);
+            auto output = Lanes::expand(0.0);
+
+            for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+            {
+                auto sample = input;
+
+                for (int band = 0; band < NUM_BANDS; ++band)
+                {
+                    const auto y = b0[mic][band] * sample + b1[mic][band] * z1[mic][band] + b2[mic][band] * z2[mic][band]
+                                 - a1[mic][band] * z1[mic][band] - a2[mic][band] * z2[mic][band];
+                    z2[mic][band] = z1[mic][band];
+                    z1[mic][band] = y;
+
+                    // Add this band's contribution, as Chamber does
+                    sample = sample + (y - input);
+                }
+
+                const auto& gain = gains[static_cast<size_t>(mic)];
+                const float sampleGain = i < gain.remainingSteps ? gain.current + gain.step * static_cast<float>(i + 1)
+                                                                 : gain.target;
+                output = output + sample * Lanes::expand(static_cast<double>(sampleGain));
+            }
+
+            output.copyToRawArray(frame);
+            for (int lane = 0; lane < numLanes; ++lane)
+                channels[first + lane][i] = static_cast<float>(frame[lane]);
+        }
+
+        for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+        {
+            for (int band = 0; band < NUM_BANDS; ++band)
+            {
+                auto& destination = bands[static_cast<size_t>(mic)][static_cast<size_t>(band)];
+                z1[mic][band].copyToRawArray(destination.z1.data() + offset);
+                z2[mic][band].copyToRawArray(destination.z2.data() + offset);
+            }
+        }
+    }
+
+    // Every register used the same ramp; advance it once
+    for (auto& gain : gains)
+    {
+        const int rampLength = juce::jmin(numSamples, gain.remainingSteps);
+        gain.remainingSteps -= rampLength;
+        gain.current = gain.remainingSteps == 0 ? gain.target : gain.current + gain.step * static_cast<float>(rampLength);
+    }
+}
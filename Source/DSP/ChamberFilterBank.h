@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "../Models/MicFrequencyBands.h"
+
+/**
+ * The microphone filters of several chambers side by side, one chamber per
+ * audio channel, for multichannel input such as 5.1 or 7.1 where every
+ * speaker channel excites a chamber of its own.
+ *
+ * Coefficients and filter state are stored as structure-of-arrays with one
+ * lane per chamber, so each band of each microphone is run for a whole SIMD
+ * register of chambers at once. The filters are the same as Chamber's (each
+ * band's peak filter adds its difference to the running sample), and each
+ * channel is replaced by the gain-weighted sum of its chamber's microphones.
+ * Microphone gains are shared by all chambers and smoothed like the
+ * RoutingMatrix cells. The bank hears each chamber from one speaker; a
+ * chamber filtered elsewhere (e.g. by Chamber::process, for several
+ * speakers) can still be mixed on the same gains with mixMicrophones().
+ */
+class ChamberFilterBank
+{
+public:
+    static constexpr int MAX_CHAMBERS = 8;
+    static constexpr int NUM_MICROPHONES = 3;
+    static constexpr int NUM_BANDS = MicFrequencyBands::NUM_FREQUENCY_BANDS;
+
+    ChamberFilterBank() = default;
+
+    /** Clear the filters and jump to the target gains. Call while not processing. */
+    void prepare(double sampleRate);
+
+    /** Copy one microphone's coefficients for one chamber; its filter state is kept. Real-time safe. */
+    void setCoefficients(int chamber, int mic, const MicFrequencyBands& response) noexcept;
+
+    /** Clear one chamber's filter state, e.g. when its lane is taken up again. Real-time safe. */
+    void resetChamber(int chamber) noexcept;
+
+    /** Set the gain a microphone should move to, for every chamber. Real-time safe. */
+    void setTargetGain(int mic, float gain) noexcept;
+
+    /**
+     * Replace a channel with the gain-weighted sum of microphone signals
+     * filtered outside the bank, on the ramp the next process() call uses.
+     * Call before process() in each block. Real-time safe.
+     */
+    void mixMicrophones(const float* const* mics, float* output, int numSamples) const noexcept;
+
+    /**
+     * Filter a block in place, and advance the microphone gains. Call once
+     * per block, even with no chambers of its own to filter.
+     * @param channels One channel per chamber, each both input and output
+     * @param numChambers Number of channels (up to MAX_CHAMBERS)
+     * @param numSamples Number of samples in each channel
+     */
+    void process(float* const* channels, int numChambers, int numSamples) noexcept;
+
+private:
+    using Lanes = juce::dsp::SIMDRegister<double>;
+    static constexpr int LANE_WIDTH = static_cast<int>(Lanes::SIMDNumElements);
+    static_assert(MAX_CHAMBERS % LANE_WIDTH == 0, "Chamber lanes must fill whole registers");
+
+    static constexpr double SMOOTHING_SECONDS = 0.02;
+
+    /** One band of one microphone, one lane per chamber. */
+    struct alignas(64) BandLanes
+    {
+        std::array<double, MAX_CHAMBERS> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+        std::array<double, MAX_CHAMBERS> z1 {}, z2 {};
+    };
+
+    struct MicGain
+    {
+        float current = 0.0f;
+        float target = 0.0f;
+        float step = 0.0f;
+        int remainingSteps = 0;
+    };
+
+    std::array<std::array<BandLanes, NUM_BANDS>, NUM_MICROPHONES> bands;
+    std::array<MicGain, NUM_MICROPHONES> gains;
+    int smoothingSteps = 1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChamberFilterBank)
+};
@@ -0,0 +1,246 @@
+#include "Metering.h"
+
+ChannelMeter::ChannelMeter()
+{
+    // Windowed-sinc interpolator with its cutoff at the original Nyquist frequency.
+    // Tap n of the full filter belongs to phase n % OVERSAMPLING.
+    constexpr int numTaps = OVERSAMPLING * TAPS_PER_PHASE;
+    constexpr double centre = (numTaps - 1) / 2.0;
+
+    for (int n = 0; n < numTaps; ++n)
+    {
+        const double t = (n - centre) / OVERSAMPLING;
+        const double sinc = std::abs(t) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+        const double window = 0.5 - 0.5 * std::cos(2.0 * juce::MathConstants<double>::pi * (n + 0.5) / numTaps);
+
+        taps[static_cast<size_t>(n % OVERSAMPLING)][static_cast<size_t>(n / OVERSAMPLING)] = static_cast<float>(sinc * window);
+    }
+}
+
+void ChannelMeter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void ChannelMeter::reset() noexcept
+{
+    history.fill(0.0f);
+    historyPosition = 0;
+    peak = 0.0f;
+    truePeak = 0.0f;
+    meanSquare = 0.0;
+
+    publishedPeak.store(0.0f, std::memory_order_relaxed);
+    publishedRms.store(0.0f, std::memory_order_relaxed);
+    publishedTruePeak.store(0.0f, std::memory_order_relaxed);
+}
+
+void ChannelMeter::process(const float* samples, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    const auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+    const float blockPeak = juce::jmax(-range.getStart(), range.getEnd());
+
+    // Independent partial sums let the compiler vectorize the reduction
+    float sums[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        sums[0] += samples[i] * samples[i];
+        sums[1] += samples[i + 1] * samples[i + 1];
+        sums[2] += samples[i + 2] * samples[i + 2];
+        sums[3] += samples[i + 3] * samples[i + 3];
+    }
+
+    for (; i < numSamples; ++i)
+        sums[0] += samples[i] * samples[i];
+
+    const double blockMeanSquare = (static_cast<double>(sums[0]) + sums[1] + sums[2] + sums[3]) / numSamples;
+    const float blockTruePeak = juce::jmax(blockPeak, measureTruePeak(samples, numSamples));
+
+    // Ballistics, applied once per block
+    const double blockSeconds = numSamples / sampleRate;
+    const float release = static_cast<float>(std::exp(-blockSeconds / PEAK_RELEASE_SECONDS));
+    const double integration = 1.0 - std::exp(-blockSeconds / RMS_WINDOW_SECONDS);
+
+    peak = juce::jmax(blockPeak, peak * release);
+    truePeak = juce::jmax(blockTruePeak, truePeak * release);
+    meanSquare += integration * (blockMeanSquare - meanSquare);
+
+    publishedPeak.store(peak, std::memory_order_relaxed);
+    publishedRms.store(static_cast<float>(std::sqrt(meanSquare)), std::memory_order_relaxed);
+    publishedTruePeak.store(truePeak, std::memory_order_relaxed);
+}
+
+float ChannelMeter::measureTruePeak(const float* samples, int numSamples) noexcept
+{
+    float maxMagnitude = 0.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        historyPosition = (historyPosition + 1) % TAPS_PER_PHASE;
+        history[static_cast<size_t>(historyPosition)] = samples[i];
+        history[static_cast<size_t>(historyPosition + TAPS_PER_PHASE)] = samples[i];
+
+        // history[historyPosition + TAPS_PER_PHASE - k] is the input k samples ago
+        const float* recent = history.data() + historyPosition + 1;
+
+        for (const auto& phase : taps)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < TAPS_PER_PHASE; ++k)
+                sum += phase[static_cast<size_t>(k)] * recent[TAPS_PER_PHASE - 1 - k];
+
+            maxMagnitude = juce::jmax(maxMagnitude, std::abs(sum));
+        }
+    }
+
+    return maxMagnitude;
+}
+
+float ChannelMeter::getPeakDecibels() const noexcept
+{
+    return juce::Decibels::gainToDecibels(publishedPeak.load(std::memory_order_relaxed), MIN_DB);
+}
+
+float ChannelMeter::getRmsDecibels() const noexcept
+{
+    return juce::Decibels::gainToDecibels(publishedRms.load(std::memory_order_relaxed), MIN_DB);
+}
+
+float ChannelMeter::getTruePeakDecibels() const noexcept
+{
+    return juce::Decibels::gainToDecibels(publishedTruePeak.load(std::memory_order_relaxed), MIN_DB);
+}
+
+//==============================================================================
+void LoudnessMeter::prepare(double sampleRate)
+{
+    // BS.1770 K-weighting, with the coefficients derived for any sample rate
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    blockSize = juce::jmax(1, juce::roundToInt(sampleRate / 10.0));
+    reset();
+}
+
+void LoudnessMeter::reset() noexcept
+{
+    shelfStates.fill({});
+    highPassStates.fill({});
+
+    blockPosition = 0;
+    blockEnergy = 0.0;
+    blockMeanSquares.fill(0.0);
+    nextBlock = 0;
+    numBlocks = 0;
+
+    publishedLoudness.store(MIN_LUFS, std::memory_order_relaxed);
+}
+
+void LoudnessMeter::setEnabled(bool shouldBeEnabled) noexcept
+{
+    enabled.store(shouldBeEnabled, std::memory_order_relaxed);
+}
+
+bool LoudnessMeter::isEnabled() const noexcept
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void LoudnessMeter::process(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (!isEnabled())
+        return;
+
+    numChannels = juce::jmin(numChannels, MAX_CHANNELS);
+    int position = 0;
+
+    while (position < numSamples)
+    {
+        const int chunk = juce::jmin(numSamples - position, blockSize - blockPosition);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float* samples = channels[channel] + position;
+            auto& shelfState = shelfStates[static_cast<size_t>(channel)];
+            auto& highPassState = highPassStates[static_cast<size_t>(channel)];
+            double energy = 0.0;
+
+            for (int i = 0; i < chunk; ++i)
+            {
+                const double weighted = highPassState.process(highPass, shelfState.process(shelf, samples[i]));
+                energy += weighted * weighted;
+            }
+
+            blockEnergy += energy;
+        }
+
+        position += chunk;
+        blockPosition += chunk;
+
+        if (blockPosition >= blockSize)
+            finishBlock();
+    }
+}
+
+void LoudnessMeter::finishBlock() noexcept
+{
+    blockMeanSquares[static_cast<size_t>(nextBlock)] = blockEnergy / blockSize;
+    nextBlock = (nextBlock + 1) % BLOCKS_PER_WINDOW;
+    numBlocks = juce::jmin(numBlocks + 1, BLOCKS_PER_WINDOW);
+
+    blockEnergy = 0.0;
+    blockPosition = 0;
+
+    double windowMeanSquare = 0.0;
+    for (int i = 0; i < numBlocks; ++i)
+        windowMeanSquare += blockMeanSquares[static_cast<size_t>(i)];
+    windowMeanSquare /= numBlocks;
+
+    const float loudness = windowMeanSquare > 0.0
+                         ? static_cast<float>(-0.691 + 10.0 * std::log10(windowMeanSquare))
+                         : MIN_LUFS;
+
+    publishedLoudness.store(juce::jmax(MIN_LUFS, loudness), std::memory_order_relaxed);
+}
+
+float LoudnessMeter::getShortTermLoudness() const noexcept
+{
+    if (!isEnabled())
+        return MIN_LUFS;
+
+    return publishedLoudness.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+/**
+ * Peak, RMS and true-peak meter for one channel.
+ *
+ * process() runs on the audio thread once per block: the block's peak comes
+ * from a vectorized min/max reduction, its mean square from a vectorizable
+ * sum, and the true peak from 4x polyphase oversampling. Meter ballistics
+ * (peak release, RMS integration) are applied per block and the results are
+ * published through relaxed atomics, so the GUI can read them at any time.
+ */
+class ChannelMeter
+{
+public:
+    static constexpr float MIN_DB = -100.0f;
+
+    ChannelMeter();
+
+    /**
+     * Prepare for playback. Not real-time safe.
+     * @param sampleRate The sample rate of the metered signal
+     */
+    void prepare(double sampleRate);
+
+    /** Clear the meter state and the published values. */
+    void reset() noexcept;
+
+    /**
+     * Measure a block of samples. Real-time safe.
+     * @param samples The samples to measure
+     * @param numSamples Number of samples
+     */
+    void process(const float* samples, int numSamples) noexcept;
+
+    /** Get the sample peak with release ballistics, in dB. */
+    float getPeakDecibels() const noexcept;
+
+    /** Get the RMS level integrated over RMS_WINDOW_SECONDS, in dB. */
+    float getRmsDecibels() const noexcept;
+
+    /** Get the inter-sample (true) peak with release ballistics, in dBTP. */
+    float getTruePeakDecibels() const noexcept;
+
+private:
+    static constexpr int OVERSAMPLING = 4;
+    static constexpr int TAPS_PER_PHASE = 12;
+    static constexpr double PEAK_RELEASE_SECONDS = 0.3;
+    static constexpr double RMS_WINDOW_SECONDS = 0.3;
+
+    float measureTruePeak(const float* samples, int numSamples) noexcept;
+
+    double sampleRate = 44100.0;
+
+    // Polyphase interpolation filter; phase p uses taps[p][0..TAPS_PER_PHASE)
+    std::array<std::array<float, TAPS_PER_PHASE>, OVERSAMPLING> taps;
+
+    // Most recent input samples, written twice so the filter reads them contiguously
+    std::array<float, TAPS_PER_PHASE * 2> history {};
+    int historyPosition = 0;
+
+    // Ballistics state (audio thread only)
+    float peak = 0.0f;
+    float truePeak = 0.0f;
+    double meanSquare = 0.0;
+
+    std::atomic<float> publishedPeak { 0.0f };
+    std::atomic<float> publishedRms { 0.0f };
+    std::atomic<float> publishedTruePeak { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelMeter)
+};
+
+/**
+ * Short-term loudness (ITU-R BS.1770 / EBU R128, 3 s window) of up to MAX_CHANNELS channels.
+ *
+ * K-weighted energy is accumulated per sample into 100 ms blocks; each completed
+ * block updates the 3 s window and the published loudness. Metering is optional
+ * and costs nothing while disabled.
+ */
+class LoudnessMeter
+{
+public:
+    static constexpr int MAX_CHANNELS = 8;
+    static constexpr float MIN_LUFS = -100.0f;
+
+    LoudnessMeter() = default;
+
+    /**
+     * Prepare for playback. Not real-time safe.
+     * @param sampleRate The sample rate of the metered signal
+     */
+    void prepare(double sampleRate);
+
+    /** Clear the filter state, window and published value. */
+    void reset() noexcept;
+
+    /**
+     * Enable or disable metering. Safe to call from any thread.
+     * @param shouldBeEnabled True to measure loudness
+     */
+    void setEnabled(bool shouldBeEnabled) noexcept;
+    bool isEnabled() const noexcept;
+
+    /**
+     * Measure a block. Real-time safe.
+     * @param channels Channel pointers
+     * @param numChannels Number of channels (extra channels beyond MAX_CHANNELS are ignored)
+     * @param numSamples Number of samples per channel
+     */
+    void process(const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Get the short-term loudness in LUFS (MIN_LUFS when silent or disabled). */
+    float getShortTermLoudness() const noexcept;
+
+private:
+    static constexpr int BLOCKS_PER_WINDOW = 30;   // 3 s of 100 ms blocks
+
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    struct FilterState
+    {
+        double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+        double process(const Biquad& filter, double x) noexcept
+        {
+            const double y = filter.b0 * x + filter.b1 * x1 + filter.b2 * x2 - filter.a1 * y1 - filter.a2 * y2;
+            x2 = x1; x1 = x;
+            y2 = y1; y1 = y;
+            return y;
+        }
+    };
+
+    void finishBlock() noexcept;
+
+    // K-weighting: high shelf followed by high pass
+    Biquad shelf;
+    Biquad highPass;
+    std::array<FilterState, MAX_CHANNELS> shelfStates;
+    std::array<FilterState, MAX_CHANNELS> highPassStates;
+
+    int blockSize = 4410;
+    int blockPosition = 0;
+    double blockEnergy = 0.0;
+
+    std::array<double, BLOCKS_PER_WINDOW> blockMeanSquares {};
+    int nextBlock = 0;
+    int numBlocks = 0;
+
+    std::atomic<bool> enabled { false };
+    std::atomic<float> publishedLoudness { MIN_LUFS };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessMeter)
+};
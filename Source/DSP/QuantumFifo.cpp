@@ -0,0 +1,15 @@
+#include "QuantumFifo.h"
+
+void QuantumFifo::prepare(int numChannels)
+{
+    inputFifo.setSize(juce::jmax(0, numChannels), QUANTUM_SIZE);
+    outputFifo.setSize(juce::jmax(0, numChannels), QUANTUM_SIZE);
+    reset();
+}
+
+void QuantumFifo::reset() noexcept
+{
+    inputFifo.clear();
+    outputFifo.clear();
+    position = 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Re-blocks host audio into fixed-size quanta.
+ *
+ * Hosts may call back with any number of samples, including tiny or irregular
+ * blocks. process() streams the host block through an input and an output
+ * FIFO and calls the kernel once for every complete QUANTUM_SIZE samples, so
+ * everything downstream runs on one known block size and the cost of each
+ * kernel call is the same regardless of how the host slices the stream.
+ *
+ * The output is delayed by exactly QUANTUM_SIZE samples, which the owner
+ * reports to the host as latency.
+ */
+class QuantumFifo
+{
+public:
+    static constexpr int QUANTUM_SIZE = 64;
+
+    QuantumFifo() = default;
+
+    /**
+     * Allocate the FIFOs. Not real-time safe.
+     * @param numChannels Number of channels passed through process()
+     */
+    void prepare(int numChannels);
+
+    /** Clear the FIFOs (the next QUANTUM_SIZE output samples are silent). */
+    void reset() noexcept;
+
+    bool isPrepared() const noexcept { return inputFifo.getNumChannels() > 0; }
+
+    int getLatencySamples() const noexcept { return QUANTUM_SIZE; }
+
+    /**
+     * Pass a host block through the FIFOs in place.
+     * @param block Host channels: read as input, overwritten with the delayed output
+     * @param processQuantum Called as processQuantum(const juce::dsp::AudioBlock<float>&)
+     *                       with exactly QUANTUM_SIZE samples to be processed in place
+     */
+    template <typename Kernel>
+    void process(const juce::dsp::AudioBlock<float>& block, Kernel&& processQuantum)
+    {
+        const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), inputFifo.getNumChannels());
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+
+        for (int done = 0; done < numSamples;)
+        {
+            const auto count = juce::jmin(QUANTUM_SIZE - position, numSamples - done);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* host = block.getChannelPointer(static_cast<size_t>(channel)) + done;
+                juce::FloatVectorOperations::copy(inputFifo.getWritePointer(channel, position), host, count);
+                juce::FloatVectorOperations::copy(host, outputFifo.getReadPointer(channel, position), count);
+            }
+
+            position += count;
+            done += count;
+
+            if (position == QUANTUM_SIZE)
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    outputFifo.copyFrom(channel, 0, inputFifo, channel, 0, QUANTUM_SIZE);
+
+                juce::dsp::AudioBlock<float> quantum(outputFifo);
+                processQuantum(quantum.getSubsetChannelBlock(0, static_cast<size_t>(numChannels)));
+                position = 0;
+            }
+        }
+    }
+
+private:
+    juce::AudioBuffer<float> inputFifo;
+    juce::AudioBuffer<float> outputFifo;
+    int position = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(QuantumFifo)
+};
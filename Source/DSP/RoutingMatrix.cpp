@@ -0,0 +1,77 @@
+#include "RoutingMatrix.h"
+
+void RoutingMatrix::prepare(double sampleRate, int maximumBlockSize, int newNumInputs, int newNumOutputs)
+{
+    jassert(newNumInputs <= MAX_INPUTS && newNumOutputs <= MAX_OUTPUTS);
+
+    numInputs = juce::jlimit(0, MAX_INPUTS, newNumInputs);
+    numOutputs = juce::jlimit(0, MAX_OUTPUTS, newNumOutputs);
+    smoothingSteps = juce::jmax(1, juce::roundToInt(sampleRate * SMOOTHING_SECONDS));
+
+    rampBuffer.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), 0.0f);
+
+    for (auto& row : cells)
+        row.fill({});
+}
+
+void RoutingMatrix::setTargetGain(int input, int output, float gain) noexcept
+{
+    auto& cell = cells[static_cast<size_t>(output)][static_cast<size_t>(input)];
+
+    if (gain == cell.target)
+        return;
+
+    cell.target = gain;
+    cell.remainingSteps = smoothingSteps;
+    cell.step = (cell.target - cell.current) / static_cast<float>(smoothingSteps);
+}
+
+void RoutingMatrix::skipSmoothing() noexcept
+{
+    for (auto& row : cells)
+    {
+        for (auto& cell : row)
+        {
+            cell.current = cell.target;
+            cell.remainingSteps = 0;
+        }
+    }
+}
+
+void RoutingMatrix::process(const float* const* inputs, float* const* outputs, int numSamples) noexcept
+{
+    jassert(numSamples <= static_cast<int>(rampBuffer.size()));
+    numSamples = juce::jmin(numSamples, static_cast<int>(rampBuffer.size()));
+
+    for (int output = 0; output < numOutputs; ++output)
+    {
+        float* destination = outputs[output];
+        juce::FloatVectorOperations::clear(destination, numSamples);
+
+        for (int input = 0; input < numInputs; ++input)
+        {
+            auto& cell = cells[static_cast<size_t>(output)][static_cast<size_t>(input)];
+
+            if (cell.remainingSteps == 0)
+            {
+                // Steady gain: one fused multiply-accumulate over the block, or nothing at all
+                if (cell.current != 0.0f)
+                    juce::FloatVectorOperations::addWithMultiply(destination, inputs[input], cell.current, numSamples);
+
+                continue;
+            }
+
+            // Ramping: write the per-sample gains, then multiply-accumulate against them
+            const int rampLength = juce::jmin(numSamples, cell.remainingSteps);
+
+            for (int i = 0; i < rampLength; ++i)
+                rampBuffer[static_cast<size_t>(i)] = cell.current + cell.step * static_cast<float>(i + 1);
+
+            cell.remainingSteps -= rampLength;
+            cell.current = cell.remainingSteps == 0 ? cell.target : rampBuffer[static_cast<size_t>(rampLength - 1)];
+
+            juce::FloatVectorOperations::fill(rampBuffer.data() + rampLength, cell.current, numSamples - rampLength);
+            juce::FloatVectorOperations::addWithMultiply(destination, inputs[input], rampBuffer.data(), numSamples);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+
+/**
+ * Mixes N input channels into M output channels through a matrix of gains.
+ *
+ * Each cell's gain is smoothed with a linear ramp when its target changes.
+ * Callers fold every gain stage (pan, volume, solo/mute, output gain) into
+ * the cell targets once per block. process() then computes each output as a
+ * sum of vectorized multiply-accumulates over the whole block, so no
+ * per-sample branching is needed.
+ */
+class RoutingMatrix
+{
+public:
+    static constexpr int MAX_INPUTS = 8;
+    static constexpr int MAX_OUTPUTS = 8;
+
+    RoutingMatrix() = default;
+
+    /**
+     * Prepare for playback. Not real-time safe.
+     * @param sampleRate The sample rate, used for the smoothing time
+     * @param maximumBlockSize The largest block process() will be given
+     * @param numInputs Number of input channels (up to MAX_INPUTS)
+     * @param numOutputs Number of output channels (up to MAX_OUTPUTS)
+     */
+    void prepare(double sampleRate, int maximumBlockSize, int numInputs, int numOutputs);
+
+    /**
+     * Set the gain a cell should move to. Real-time safe; call from the audio thread.
+     * @param input Input channel index
+     * @param output Output channel index
+     * @param gain Linear gain
+     */
+    void setTargetGain(int input, int output, float gain) noexcept;
+
+    /** Jump every cell straight to its target gain. */
+    void skipSmoothing() noexcept;
+
+    /**
+     * Mix a block. Outputs are overwritten.
+     * @param inputs numInputs channel pointers
+     * @param outputs numOutputs channel pointers (must not alias the inputs)
+     * @param numSamples Number of samples (at most the prepared maximum block size)
+     */
+    void process(const float* const* inputs, float* const* outputs, int numSamples) noexcept;
+
+private:
+    static constexpr double SMOOTHING_SECONDS = 0.02;
+
+    struct Cell
+    {
+        float current = 0.0f;
+        float target = 0.0f;
+        float step = 0.0f;
+        int remainingSteps = 0;
+    };
+
+    std::array<std::array<Cell, MAX_INPUTS>, MAX_OUTPUTS> cells;
+    int numInputs = 0;
+    int numOutputs = 0;
+    int smoothingSteps = 1;
+
+    // Per-sample gains of a cell that is ramping
+    std::vector<float> rampBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RoutingMatrix)
+};
@@ -0,0 +1,126 @@
+#include "SpectrumAnalyser.h"
+
+SpectrumAnalyser::SpectrumAnalyser()
+    : juce::Thread("Rippleator Spectrum Analyser")
+{
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), FFT_SIZE,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+    updateBinEdges(44100.0);
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stop();
+}
+
+int SpectrumAnalyser::addSource(const CircularBuffer& buffer)
+{
+    jassert(!isThreadRunning());
+
+    sources.push_back(std::make_unique<Source>(buffer));
+    return static_cast<int>(sources.size()) - 1;
+}
+
+void SpectrumAnalyser::start(double sampleRate)
+{
+    if (isThreadRunning())
+        return;
+
+    updateBinEdges(sampleRate);
+
+    // Start from live audio rather than whatever built up while stopped
+    for (auto& source : sources)
+    {
+        source->reader.skipToLatest();
+        source->history.fill(0.0f);
+    }
+
+    startThread(juce::Thread::Priority::low);
+}
+
+void SpectrumAnalyser::stop()
+{
+    stopThread(1000);
+}
+
+int SpectrumAnalyser::readSpectra(int sourceIndex, Spectrum* destination, int maxFrames) noexcept
+{
+    auto& source = *sources[static_cast<size_t>(sourceIndex)];
+
+    int start1, size1, start2, size2;
+    source.fifo.prepareToRead(maxFrames, start1, size1, start2, size2);
+
+    std::copy_n(source.frames.begin() + start1, size1, destination);
+    std::copy_n(source.frames.begin() + start2, size2, destination + size1);
+
+    source.fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+float SpectrumAnalyser::getBinFrequency(float bin)
+{
+    return MIN_FREQUENCY * std::pow(MAX_FREQUENCY / MIN_FREQUENCY, bin / NUM_BINS);
+}
+
+void SpectrumAnalyser::run()
+{
+    while (!threadShouldExit())
+    {
+        for (auto& source : sources)
+        {
+            while (source->reader.getNumReady() >= HOP_SIZE && !threadShouldExit())
+                analyse(*source);
+        }
+
+        wait(10);
+    }
+}
+
+void SpectrumAnalyser::analyse(Source& source)
+{
+    auto& history = source.history;
+
+    // Slide the window along by one hop
+    std::copy(history.begin() + HOP_SIZE, history.end(), history.begin());
+
+    float* newSamples = history.data() + FFT_SIZE - HOP_SIZE;
+    const int numRead = source.reader.getSamples(newSamples, HOP_SIZE);
+    std::fill(newSamples + numRead, newSamples + HOP_SIZE, 0.0f);
+
+    juce::FloatVectorOperations::multiply(fftData.data(), history.data(), window.data(), FFT_SIZE);
+    juce::FloatVectorOperations::clear(fftData.data() + FFT_SIZE, FFT_SIZE);
+
+    fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    int start1, size1, start2, size2;
+    source.fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    // Nobody is reading: drop the frame
+    if (size1 == 0)
+        return;
+
+    auto& frame = source.frames[static_cast<size_t>(start1)];
+
+    // A full-scale sine reads 0 dB: the Hann window has a coherent gain of 0.5
+    constexpr float magnitudeScale = 4.0f / FFT_SIZE;
+
+    for (int bin = 0; bin < NUM_BINS; ++bin)
+    {
+        const int first = binEdges[static_cast<size_t>(bin)];
+        const int last = juce::jmax(first + 1, binEdges[static_cast<size_t>(bin) + 1]);
+        const float peak = juce::FloatVectorOperations::findMaximum(fftData.data() + first, last - first);
+
+        frame[static_cast<size_t>(bin)] = juce::Decibels::gainToDecibels(peak * magnitudeScale, MIN_DB);
+    }
+
+    source.fifo.finishedWrite(1);
+}
+
+void SpectrumAnalyser::updateBinEdges(double sampleRate)
+{
+    for (int edge = 0; edge <= NUM_BINS; ++edge)
+    {
+        const double fftBin = getBinFrequency(static_cast<float>(edge)) * FFT_SIZE / sampleRate;
+        binEdges[static_cast<size_t>(edge)] = juce::jlimit(1, FFT_SIZE / 2 - 1, juce::roundToInt(fftBin));
+    }
+}
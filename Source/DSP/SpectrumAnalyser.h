@@ -0,0 +1,93 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "../Models/CircularBuffer.h"
+
+/**
+ * Background spectrum analysis of one or more sample streams.
+ *
+ * Each source is read through its own CircularBuffer::Reader on a dedicated
+ * thread, transformed with a Hann-windowed real FFT every HOP_SIZE samples and
+ * reduced to NUM_BINS log-spaced frequency bins in dB. Finished frames are
+ * queued per source, ready to draw, for a single reader (normally the GUI).
+ */
+class SpectrumAnalyser : private juce::Thread
+{
+public:
+    static constexpr int FFT_ORDER = 11;
+    static constexpr int FFT_SIZE = 1 << FFT_ORDER;
+    static constexpr int HOP_SIZE = FFT_SIZE / 2;
+    static constexpr int NUM_BINS = 128;
+    static constexpr int FRAME_QUEUE_SIZE = 64;
+    static constexpr float MIN_FREQUENCY = 20.0f;
+    static constexpr float MAX_FREQUENCY = 20000.0f;
+    static constexpr float MIN_DB = -90.0f;
+
+    /** Levels in dB (MIN_DB to 0) of the log-spaced bins, lowest frequency first. */
+    using Spectrum = std::array<float, NUM_BINS>;
+
+    SpectrumAnalyser();
+    ~SpectrumAnalyser() override;
+
+    /**
+     * Add a stream to analyse. Must be called before start().
+     * @param buffer The stream; must outlive the analyser
+     * @return The index used to read this source's spectra
+     */
+    int addSource(const CircularBuffer& buffer);
+
+    /**
+     * Start the analysis thread
+     * @param sampleRate The sample rate of the analysed streams
+     */
+    void start(double sampleRate);
+
+    /** Stop the analysis thread. */
+    void stop();
+
+    /**
+     * Pop the frames analysed since the last call, oldest first.
+     * @param sourceIndex Index returned by addSource()
+     * @param destination Where to copy the frames
+     * @param maxFrames Maximum number of frames to copy
+     * @return The number of frames copied
+     */
+    int readSpectra(int sourceIndex, Spectrum* destination, int maxFrames) noexcept;
+
+    /**
+     * Get the frequency at a (fractional) bin position
+     * @param bin Bin position, 0 to NUM_BINS
+     * @return The frequency in Hz
+     */
+    static float getBinFrequency(float bin);
+
+private:
+    struct Source
+    {
+        explicit Source(const CircularBuffer& buffer) : reader(buffer) {}
+
+        CircularBuffer::Reader reader;
+        std::array<float, FFT_SIZE> history {};
+
+        juce::AbstractFifo fifo { FRAME_QUEUE_SIZE };
+        std::array<Spectrum, FRAME_QUEUE_SIZE> frames;
+    };
+
+    void run() override;
+    void analyse(Source& source);
+    void updateBinEdges(double sampleRate);
+
+    juce::dsp::FFT fft { FFT_ORDER };
+    std::array<float, FFT_SIZE> window;
+    std::array<float, FFT_SIZE * 2> fftData;
+
+    // FFT bin index at each edge of the log-spaced bins
+    std::array<int, NUM_BINS + 1> binEdges;
+
+    std::vector<std::unique_ptr<Source>> sources;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyser)
+};
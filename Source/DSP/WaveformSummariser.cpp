@@ -0,0 +1,74 @@
+#include "WaveformSummariser.h"
+
+void WaveformSummariser::setSamplesPerColumn(int numSamples) noexcept
+{
+    samplesPerColumn.store(juce::jmax(1, numSamples), std::memory_order_relaxed);
+}
+
+void WaveformSummariser::process(const float* samples, int numSamples) noexcept
+{
+    const int columnSize = samplesPerColumn.load(std::memory_order_relaxed);
+
+    while (numSamples > 0)
+    {
+        const int chunk = juce::jmin(numSamples, juce::jmax(1, columnSize - currentCount));
+        const auto range = juce::FloatVectorOperations::findMinAndMax(samples, chunk);
+
+        double sumOfSquares = 0.0;
+        for (int i = 0; i < chunk; ++i)
+            sumOfSquares += static_cast<double>(samples[i]) * samples[i];
+
+        if (currentCount == 0)
+        {
+            currentMin = range.getStart();
+            currentMax = range.getEnd();
+        }
+        else
+        {
+            currentMin = juce::jmin(currentMin, range.getStart());
+            currentMax = juce::jmax(currentMax, range.getEnd());
+        }
+
+        currentSumOfSquares += sumOfSquares;
+        currentCount += chunk;
+
+        if (currentCount >= columnSize)
+            pushColumn();
+
+        samples += chunk;
+        numSamples -= chunk;
+    }
+}
+
+void WaveformSummariser::pushColumn() noexcept
+{
+    WaveformColumn column;
+    column.min = currentMin;
+    column.max = currentMax;
+    column.rms = static_cast<float>(std::sqrt(currentSumOfSquares / currentCount));
+
+    currentSumOfSquares = 0.0;
+    currentCount = 0;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    // Reader isn't keeping up (or isn't running): drop the column
+    if (size1 == 0)
+        return;
+
+    columns[static_cast<size_t>(start1)] = column;
+    fifo.finishedWrite(1);
+}
+
+int WaveformSummariser::readColumns(WaveformColumn* destination, int maxColumns) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(maxColumns, start1, size1, start2, size2);
+
+    std::copy_n(columns.begin() + start1, size1, destination);
+    std::copy_n(columns.begin() + start2, size2, destination + size1);
+
+    fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+/** Decimated summary of a run of samples, one per pixel column of a waveform display. */
+struct WaveformColumn
+{
+    float min = 0.0f;
+    float max = 0.0f;
+    float rms = 0.0f;
+};
+
+/**
+ * Reduces an audio stream to min/max/RMS columns on the audio thread and hands
+ * them to a single reader (normally the GUI) through a lock-free FIFO.
+ *
+ * The reader chooses the column size with setSamplesPerColumn(), typically
+ * the number of samples that one pixel of the display covers, so the work
+ * left on the GUI side depends only on the display width and not on the
+ * sample rate.
+ */
+class WaveformSummariser
+{
+public:
+    static constexpr int QUEUE_SIZE = 2048;
+
+    WaveformSummariser() = default;
+
+    /**
+     * Set how many samples each column summarises. Safe to call from any thread;
+     * the audio thread picks the new value up at the next column boundary.
+     * @param numSamples Samples per column (at least 1)
+     */
+    void setSamplesPerColumn(int numSamples) noexcept;
+
+    /**
+     * Accumulate a block of samples, pushing a column each time one is complete.
+     * Real-time safe. If the reader has fallen behind, completed columns are dropped.
+     * @param samples The samples to summarise
+     * @param numSamples Number of samples
+     */
+    void process(const float* samples, int numSamples) noexcept;
+
+    /**
+     * Pop completed columns, oldest first. Must only be called from one reader thread.
+     * @param destination Where to copy the columns
+     * @param maxColumns Maximum number of columns to copy
+     * @return The number of columns copied
+     */
+    int readColumns(WaveformColumn* destination, int maxColumns) noexcept;
+
+private:
+    void pushColumn() noexcept;
+
+    std::atomic<int> samplesPerColumn { 256 };
+
+    // Partially accumulated column (audio thread only)
+    float currentMin = 0.0f;
+    float currentMax = 0.0f;
+    double currentSumOfSquares = 0.0;
+    int currentCount = 0;
+
+    juce::AbstractFifo fifo { QUEUE_SIZE };
+    std::array<WaveformColumn, QUEUE_SIZE> columns;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformSummariser)
+};
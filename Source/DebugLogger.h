@@ -1,95 +1,143 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <fstream>
 #include <string>
 #include <mutex>
 #include <ctime>
 #include <iomanip>
+#include <unordered_map>
+#include "Utils/LogFormat.h"
+#include "Utils/MpscRing.h"
+
+// Compile-time log filtering. Both values are normally supplied by CMake (see
+// RIPPLEATOR_LOG_LEVEL / RIPPLEATOR_LOG_CATEGORIES in CMakeLists.txt).
+// A call site whose level or category is filtered out compiles to nothing:
+// its arguments are never evaluated.
+#ifndef RIPPLEATOR_LOG_LEVEL
+ #define RIPPLEATOR_LOG_LEVEL 5            // 0 = trace, 1 = debug, 2 = info, 3 = warning, 4 = error, 5 = off
+#endif
+
+#ifndef RIPPLEATOR_LOG_CATEGORIES
+ #define RIPPLEATOR_LOG_CATEGORIES 0xFFFFFFFFu // bit n enables LogCategory n
+#endif
+
+/**
+ * Log a message with compile-time category and level filtering.
+ *
+ * The format string must be a string literal and uses "{}" placeholders:
+ *     RIPPLE_LOG(Chamber, Debug, "Speaker moved to ({}, {})", x, y);
+ *
+ * Arguments are captured by value into a fixed-size record (no allocation) and
+ * pushed to a lock-free queue, so this is safe to use on the audio thread.
+ */
+#define RIPPLE_LOG(category, level, ...) \
+    do { \
+        if constexpr (DebugLogger::isEnabled(LogCategory::category, LogLevel::level)) \
+            DebugLogger::enqueue(LogCategory::category, LogLevel::level, __VA_ARGS__); \
+    } while (false)
 
 /**
  * A simple debug logger for the Rippleator VST plugin.
  * This class provides file-based logging functionality to help track
  * initialization, audio processing, and ray tracing operations.
+ *
+ * Log calls are pushed as fixed-size binary records into a lock-free MPSC ring.
+ * A background thread drains the ring into a buffered binary .rlog file on the
+ * desktop; use Tools/LogDecoder to turn that file into text.
  */
 class DebugLogger
 {
 public:
+    /** True if any category/level combination is compiled in. */
+    static constexpr bool anyEnabled = RIPPLEATOR_LOG_LEVEL < static_cast<int>(LogLevel::Off)
+                                    && (RIPPLEATOR_LOG_CATEGORIES) != 0;
+
+    static constexpr bool isEnabled(LogCategory category, LogLevel level)
+    {
+        return static_cast<int>(level) >= RIPPLEATOR_LOG_LEVEL
+            && static_cast<int>(level) < static_cast<int>(LogLevel::Off)
+            && ((RIPPLEATOR_LOG_CATEGORIES) & (1u << static_cast<unsigned>(category))) != 0;
+    }
+
     /**
      * Initialize the logger.
-     * This should be called once at the start of the application.
+     * Call once per plugin instance (paired with shutdown()). The first call
+     * creates the log file and starts the background writer thread.
      */
     static void initialize()
     {
-// #ifdef NDEBUG
-//         return;
-// #endif
+        if constexpr (!anyEnabled)
+            return;
+
         std::lock_guard<std::mutex> lock(getMutex());
-        
+
+        if (getInstanceCount()++ > 0)
+            return;
+
         // Create log file with timestamp in filename
         auto time = std::time(nullptr);
         auto localTime = std::localtime(&time);
-        
+
         std::ostringstream filename;
         filename << "Rippleator_Debug_";
         filename << std::put_time(localTime, "%Y%m%d_%H%M%S");
-        filename << ".log";
-        
+        filename << ".rlog";
+
         getLogFilePath() = juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
                           .getChildFile(filename.str());
-        
-        // Open the file and write header
-        std::ofstream logFile(getLogFilePath().getFullPathName().toStdString(), std::ios::out);
-        if (logFile.is_open())
-        {
-            logFile << "=== Rippleator Debug Log ===" << std::endl;
-            logFile << "Started at: " << std::put_time(localTime, "%Y-%m-%d %H:%M:%S") << std::endl;
-            logFile << "================================" << std::endl << std::endl;
-            logFile.close();
-        }
+
+        // Construct the ring here rather than on the first (possibly real-time) log call
+        getRing();
+
+        getWriter() = std::make_unique<Writer>(getLogFilePath());
+        getWriter()->startThread(juce::Thread::Priority::background);
     }
-    
+
     /**
-     * Log a message to the debug log file.
-     * @param message The message to log
+     * Release one reference to the logger.
+     * The last call flushes pending records and stops the writer thread.
      */
-    static void log(const std::string& message)
+    static void shutdown()
     {
-// #ifdef NDEBUG
-//         return;
-// #endif
-        std::lock_guard<std::mutex> lock(getMutex());
-        
-        // Get current time
-        auto time = std::time(nullptr);
-        auto localTime = std::localtime(&time);
-        
-        // Format timestamp
-        std::ostringstream timestamp;
-        timestamp << std::put_time(localTime, "%H:%M:%S.") 
-                 << std::setfill('0') << std::setw(3) 
-                 << (juce::Time::getMillisecondCounter() % 1000);
-        
-        // Open file in append mode
-        std::ofstream logFile(getLogFilePath().getFullPathName().toStdString(), std::ios::app);
-        if (logFile.is_open())
+        if constexpr (!anyEnabled)
+            return;
+
+        std::unique_ptr<Writer> writer;
+
         {
-            logFile << "[" << timestamp.str() << "] " << message << std::endl;
-            logFile.close();
+            std::lock_guard<std::mutex> lock(getMutex());
+
+            if (getInstanceCount() == 0 || --getInstanceCount() > 0)
+                return;
+
+            writer = std::move(getWriter());
         }
+
+        if (writer != nullptr)
+            writer->stopThread(1000);
     }
-    
+
     /**
-     * Log a message with a category prefix.
-     * @param category The category of the log message (e.g., "INIT", "AUDIO", "RAY")
-     * @param message The message to log
+     * Capture a log record and hand it to the writer thread.
+     * Lock-free and allocation-free: if the ring is full the record is dropped
+     * and counted, and the writer reports the number of dropped records.
      */
-    static void logWithCategory(const std::string& category, const std::string& message)
+    template <typename... Args>
+    static void enqueue(LogCategory category, LogLevel level, const char* format, const Args&... args) noexcept
     {
-        return;
-        log("[" + category + "] " + message);
+        static_assert(sizeof...(Args) <= LogArgs::MAX_ARGS, "Too many RIPPLE_LOG arguments");
+
+        LogRecord record;
+        record.ticks = juce::Time::getHighResolutionTicks();
+        record.format = format;
+        record.category = category;
+        record.level = level;
+        (record.args.capture(args), ...);
+
+        if (!getRing().tryPush(record))
+            getDroppedCount().fetch_add(1, std::memory_order_relaxed);
     }
-    
+
     /**
      * Get the path to the log file.
      * @return The path to the log file
@@ -99,10 +147,140 @@ public:
         static juce::File logFilePath;
         return logFilePath;
     }
-    
+
 private:
+    static constexpr size_t RING_SIZE = 2048;
+    using Ring = MpscRing<LogRecord, RING_SIZE>;
+
+    /** Background thread that drains the ring into the binary log file. */
+    class Writer : public juce::Thread
+    {
+    public:
+        explicit Writer(const juce::File& file)
+            : juce::Thread("Rippleator Logger"),
+              stream(file, 1 << 16)
+        {
+            stream.setPosition(0);
+            stream.truncate();
+
+            LogFile::Header header {};
+            std::copy(std::begin(LogFile::MAGIC), std::end(LogFile::MAGIC), header.magic);
+            header.version = LogFile::VERSION;
+            header.recordSize = static_cast<uint32_t>(sizeof(LogFile::Record));
+            header.startTimeMs = juce::Time::currentTimeMillis();
+            header.anchorTicks = juce::Time::getHighResolutionTicks();
+            header.ticksPerSecond = juce::Time::getHighResolutionTicksPerSecond();
+
+            stream.write(&header, sizeof(header));
+            stream.flush();
+        }
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                drain();
+                wait(50);
+            }
+
+            drain();
+        }
+
+    private:
+        void drain()
+        {
+            if (stream.failedToOpen())
+                return;
+
+            bool wroteAnything = false;
+            LogRecord record;
+
+            while (getRing().tryPop(record))
+            {
+                writeRecord(record);
+                wroteAnything = true;
+            }
+
+            if (auto dropped = getDroppedCount().exchange(0); dropped > 0)
+            {
+                LogRecord droppedRecord;
+                droppedRecord.ticks = juce::Time::getHighResolutionTicks();
+                droppedRecord.format = "{} log records dropped (queue full)";
+                droppedRecord.category = LogCategory::Logger;
+                droppedRecord.level = LogLevel::Warning;
+                droppedRecord.args.capture(dropped);
+
+                writeRecord(droppedRecord);
+                wroteAnything = true;
+            }
+
+            if (wroteAnything)
+                stream.flush();
+        }
+
+        void writeRecord(const LogRecord& record)
+        {
+            LogFile::Record fileRecord {};
+            fileRecord.ticks = record.ticks;
+            fileRecord.formatId = getFormatId(record.format);
+            fileRecord.category = record.category;
+            fileRecord.level = record.level;
+            fileRecord.args = record.args;
+
+            stream.writeByte(static_cast<char>(LogFile::EntryType::Record));
+            stream.write(&fileRecord, sizeof(fileRecord));
+        }
+
+        // Format strings are literals, so their address identifies them.
+        // Each one is written to the file the first time it is seen.
+        uint32_t getFormatId(const char* format)
+        {
+            if (auto it = formatIds.find(format); it != formatIds.end())
+                return it->second;
+
+            const auto id = static_cast<uint32_t>(formatIds.size());
+            formatIds.emplace(format, id);
+
+            const auto length = static_cast<uint16_t>(std::min<size_t>(std::strlen(format), 0xFFFF));
+
+            stream.writeByte(static_cast<char>(LogFile::EntryType::FormatString));
+            stream.write(&id, sizeof(id));
+            stream.write(&length, sizeof(length));
+            stream.write(format, length);
+
+            return id;
+        }
+
+        juce::FileOutputStream stream;
+        std::unordered_map<const char*, uint32_t> formatIds;
+    };
+
+    static Ring& getRing()
+    {
+        static Ring ring;
+        return ring;
+    }
+
+    static std::atomic<juce::uint32>& getDroppedCount()
+    {
+        static std::atomic<juce::uint32> dropped { 0 };
+        return dropped;
+    }
+
+    static std::unique_ptr<Writer>& getWriter()
+    {
+        static std::unique_ptr<Writer> writer;
+        return writer;
+    }
+
+    static int& getInstanceCount()
+    {
+        static int count = 0;
+        return count;
+    }
+
     /**
-     * Get the mutex used for thread safety.
+     * Get the mutex guarding initialize() and shutdown().
      * @return Reference to the mutex
      */
     static std::mutex& getMutex()
@@ -110,4 +288,4 @@ private:
         static std::mutex mutex;
         return mutex;
     }
-};
\ No newline at end of file
+};
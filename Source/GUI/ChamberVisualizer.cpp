@@ -1,8 +1,8 @@
 #include "ChamberVisualizer.h"
 #include "../PluginProcessor.h"
 
-ChamberVisualizer::ChamberVisualizer(Chamber& chamber)
-    : chamber(chamber)
+ChamberVisualizer::ChamberVisualizer(Chamber& chamberToShow)
+    : chamber(&chamberToShow)
 {
     // Initialize color map
     setColorMap(juce::Colours::blue, juce::Colours::red);
@@ -27,7 +27,7 @@ void ChamberVisualizer::paint(juce::Graphics& g)
     g.fillAll(juce::Colours::black);
     
     // Draw ray paths
-    const auto& rays = chamber.getCachedRays();
+    const auto& rays = chamber->getCachedRays();
     
     // Draw rays with varying colors based on intensity and bounce count
     for (const auto& ray : rays)
@@ -62,7 +62,7 @@ void ChamberVisualizer::paint(juce::Graphics& g)
     }
     
     // Draw zone boundaries
-    const auto& zones = chamber.getZones();
+    const auto& zones = chamber->getZones();
     
     for (int i = 0; i < zones.size(); ++i)
     {
@@ -97,24 +97,30 @@ void ChamberVisualizer::paint(juce::Graphics& g)
         g.drawText(densityText, x + 5, y + 5, 50, 20, juce::Justification::left);
     }
     
-    // Draw speaker position
-    auto speakerPos = chamber.getSpeakerPosition();
-    float speakerX = speakerPos.x * bounds.getWidth();
-    float speakerY = speakerPos.y * bounds.getHeight();
-    
-    // Use different color for the speaker being dragged
-    if (currentDragTarget == DragTarget::Speaker)
-        g.setColour(juce::Colours::orange);
-    else
-        g.setColour(juce::Colours::yellow);
+    // Draw speaker positions, numbered when there are several
+    const int numSpeakers = chamber->getNumSpeakers();
+    for (int i = 0; i < numSpeakers; ++i)
+    {
+        auto speakerPos = chamber->getSpeakerPosition(i);
+        float speakerX = speakerPos.x * bounds.getWidth();
+        float speakerY = speakerPos.y * bounds.getHeight();
+        
+        // Use different color for the speaker being dragged
+        if (currentDragTarget == DragTarget::Speaker && i == draggedSpeakerIndex)
+            g.setColour(juce::Colours::orange);
+        else
+            g.setColour(juce::Colours::yellow);
+            
+        g.fillEllipse(speakerX - 5.0f, speakerY - 5.0f, 10.0f, 10.0f);
         
-    g.fillEllipse(speakerX - 5.0f, speakerY - 5.0f, 10.0f, 10.0f);
-    g.drawText("S", speakerX - 4.0f, speakerY - 15.0f, 10.0f, 10.0f, juce::Justification::centred);
+        const juce::String label = numSpeakers > 1 ? "S" + juce::String(i + 1) : juce::String("S");
+        g.drawText(label, speakerX - 8.0f, speakerY - 15.0f, 16.0f, 10.0f, juce::Justification::centred);
+    }
     
     // Draw microphone positions
     for (int i = 0; i < 3; ++i)
     {
-        auto micPos = chamber.getMicrophonePosition(i);
+        auto micPos = chamber->getMicrophonePosition(i);
         float micX = micPos.x * bounds.getWidth();
         float micY = micPos.y * bounds.getHeight();
         
@@ -149,6 +155,25 @@ void ChamberVisualizer::setColorMap(const juce::Colour& from, const juce::Colour
     colorMap.addColour(0.5, juce::Colours::white); // Add a midpoint for better visualization
 }
 
+void ChamberVisualizer::setChamber(Chamber& chamberToShow)
+{
+    if (&chamberToShow == chamber)
+        return;
+    
+    // A drag in progress belongs to the chamber it started on
+    if (currentDragTarget != DragTarget::None)
+    {
+        chamber->endGesture();
+        currentDragTarget = DragTarget::None;
+        draggedMicIndex = -1;
+        draggedSpeakerIndex = -1;
+        draggedZoneIndex = -1;
+    }
+    
+    chamber = &chamberToShow;
+    repaint();
+}
+
 void ChamberVisualizer::mouseDown(const juce::MouseEvent& e)
 {
     auto mousePos = e.position;
@@ -159,14 +184,17 @@ void ChamberVisualizer::mouseDown(const juce::MouseEvent& e)
     {
         currentDragTarget = DragTarget::Microphone;
         setMouseCursor(juce::MouseCursor::DraggingHandCursor);
+        chamber->beginGesture();
         return;
     }
     
-    // Check if we're clicking on the speaker
-    if (isSpeakerAtPosition(mousePos))
+    // Check if we're clicking on a speaker
+    draggedSpeakerIndex = getSpeakerAtPosition(mousePos);
+    if (draggedSpeakerIndex >= 0)
     {
         currentDragTarget = DragTarget::Speaker;
         setMouseCursor(juce::MouseCursor::DraggingHandCursor);
+        chamber->beginGesture();
         return;
     }
     
@@ -175,6 +203,7 @@ void ChamberVisualizer::mouseDown(const juce::MouseEvent& e)
     {
         currentDragTarget = DragTarget::ZoneCorner;
         setMouseCursor(juce::MouseCursor::DraggingHandCursor);
+        chamber->beginGesture();
         return;
     }
     
@@ -197,21 +226,22 @@ void ChamberVisualizer::mouseDrag(const juce::MouseEvent& e)
             if (draggedMicIndex >= 0)
             {
                 // Update microphone position
-                chamber.setMicrophonePosition(draggedMicIndex, normX, normY);
+                chamber->setMicrophonePosition(draggedMicIndex, normX, normY);
             }
             break;
             
         case DragTarget::Speaker:
-        {
-            // Allow speaker to be placed anywhere in the chamber
-            chamber.setSpeakerPosition(normX, normY);
+            if (draggedSpeakerIndex >= 0)
+            {
+                // Allow speakers to be placed anywhere in the chamber
+                chamber->setSpeakerPosition(draggedSpeakerIndex, normX, normY);
+            }
             break;
-        }
             
         case DragTarget::ZoneCorner:
             if (draggedZoneIndex >= 0)
             {
-                const auto& zones = chamber.getZones();
+                const auto& zones = chamber->getZones();
                 if (draggedZoneIndex < zones.size())
                 {
                     // Get current zone bounds
@@ -252,7 +282,7 @@ void ChamberVisualizer::mouseDrag(const juce::MouseEvent& e)
                     }
                     
                     // Update zone bounds
-                    chamber.setZoneBounds(draggedZoneIndex, x, y, width, height);
+                    chamber->setZoneBounds(draggedZoneIndex, x, y, width, height);
                 }
             }
             break;
@@ -270,20 +300,48 @@ void ChamberVisualizer::mouseUp(const juce::MouseEvent& e)
 {
     if (currentDragTarget != DragTarget::None)
     {
+        // Retraces are progressive only while dragging
+        chamber->endGesture();
         currentDragTarget = DragTarget::None;
         draggedMicIndex = -1;
+        draggedSpeakerIndex = -1;
         draggedZoneIndex = -1;
         setMouseCursor(juce::MouseCursor::PointingHandCursor);
     }
 }
 
+void ChamberVisualizer::mouseDoubleClick(const juce::MouseEvent& e)
+{
+    // The second click has already started a drag gesture on a speaker, which
+    // records the removal as its undo step when the button is released
+    if (currentDragTarget == DragTarget::Speaker)
+    {
+        if (draggedSpeakerIndex >= 0 && chamber->getNumSpeakers() > 1)
+        {
+            chamber->removeSpeaker(draggedSpeakerIndex);
+            draggedSpeakerIndex = -1;
+            repaint();
+        }
+        return;
+    }
+    
+    if (currentDragTarget != DragTarget::None || chamber->getNumSpeakers() >= Chamber::MAX_SPEAKERS)
+        return;
+    
+    auto bounds = getLocalBounds().toFloat();
+    
+    chamber->checkpointGeometry();
+    chamber->addSpeaker(e.position.x / bounds.getWidth(), e.position.y / bounds.getHeight());
+    repaint();
+}
+
 int ChamberVisualizer::getMicrophoneAtPosition(const juce::Point<float>& position)
 {
     auto bounds = getLocalBounds().toFloat();
     
     for (int i = 0; i < 3; ++i)
     {
-        auto micPos = chamber.getMicrophonePosition(i);
+        auto micPos = chamber->getMicrophonePosition(i);
         float micX = micPos.x * bounds.getWidth();
         float micY = micPos.y * bounds.getHeight();
         
@@ -298,22 +356,31 @@ int ChamberVisualizer::getMicrophoneAtPosition(const juce::Point<float>& positio
     return -1; // No microphone at this position
 }
 
-bool ChamberVisualizer::isSpeakerAtPosition(const juce::Point<float>& position)
+int ChamberVisualizer::getSpeakerAtPosition(const juce::Point<float>& position)
 {
     auto bounds = getLocalBounds().toFloat();
-    auto speakerPos = chamber.getSpeakerPosition();
-    float speakerX = speakerPos.x * bounds.getWidth();
-    float speakerY = speakerPos.y * bounds.getHeight();
     
-    // Check if position is within the speaker circle (radius 10)
-    float distance = std::sqrt(std::pow(position.x - speakerX, 2) + std::pow(position.y - speakerY, 2));
-    return distance <= 10.0f;
+    for (int i = 0; i < chamber->getNumSpeakers(); ++i)
+    {
+        auto speakerPos = chamber->getSpeakerPosition(i);
+        float speakerX = speakerPos.x * bounds.getWidth();
+        float speakerY = speakerPos.y * bounds.getHeight();
+        
+        // Check if position is within the speaker circle (radius 10)
+        float distance = std::sqrt(std::pow(position.x - speakerX, 2) + std::pow(position.y - speakerY, 2));
+        if (distance <= 10.0f)
+        {
+            return i;
+        }
+    }
+    
+    return -1; // No speaker at this position
 }
 
 bool ChamberVisualizer::getZoneCornerAtPosition(const juce::Point<float>& position, int& zoneIndex, ZoneCorner& corner)
 {
     auto bounds = getLocalBounds().toFloat();
-    const auto& zones = chamber.getZones();
+    const auto& zones = chamber->getZones();
     
     // Handle size for zone corners
     float handleSize = 8.0f;
@@ -25,6 +25,9 @@ public:
      */
     void setColorMap(const juce::Colour& from, const juce::Colour& to);
     
+    /** Show and edit another chamber, e.g. another channel's in a multichannel layout. */
+    void setChamber(Chamber& chamberToShow);
+    
     void startTimer(int intervalMs = 50) { juce::Timer::startTimer(intervalMs); }
     void stopTimer() { juce::Timer::stopTimer(); }
     
@@ -32,9 +35,12 @@ public:
     void mouseDown(const juce::MouseEvent& e) override;
     void mouseDrag(const juce::MouseEvent& e) override;
     void mouseUp(const juce::MouseEvent& e) override;
+    
+    // Double-clicking empty space adds a speaker, double-clicking a speaker removes it
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
 
 private:
-    Chamber& chamber;
+    Chamber* chamber;
     juce::ColourGradient colorMap;
     
     // Dragging state
@@ -47,6 +53,7 @@ private:
     
     DragTarget currentDragTarget = DragTarget::None;
     int draggedMicIndex = -1;
+    int draggedSpeakerIndex = -1;
     int draggedZoneIndex = -1;
     enum class ZoneCorner {
         TopLeft,
@@ -58,7 +65,7 @@ private:
     
     // Helper methods to check if a point is near a draggable element
     int getMicrophoneAtPosition(const juce::Point<float>& position);
-    bool isSpeakerAtPosition(const juce::Point<float>& position);
+    int getSpeakerAtPosition(const juce::Point<float>& position);
     bool getZoneCornerAtPosition(const juce::Point<float>& position, int& zoneIndex, ZoneCorner& corner);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChamberVisualizer)
@@ -9,8 +9,8 @@ FrequencyVisualizer::FrequencyVisualizer(const juce::String& name)
     nameLabel.setJustificationType(juce::Justification::centredLeft);
     addAndMakeVisible(nameLabel);
     
-    // Initialize with 8 frequency bands (matching Chamber::NUM_FREQUENCY_BANDS)
     frequencyBands = MicFrequencyBands();
+    spectrum.fill(SpectrumAnalyser::MIN_DB);
 }
 
 FrequencyVisualizer::~FrequencyVisualizer()
@@ -26,65 +26,145 @@ void FrequencyVisualizer::paint(juce::Graphics& g)
     g.setColour(juce::Colours::grey);
     g.drawRect(getLocalBounds(), 1);
     
-    // Draw frequency bands
-    auto bounds = getLocalBounds().reduced(2, 20).withTrimmedTop(10);
+    if (spectrumBounds.isEmpty())
+        return;
     
-    int numBands = static_cast<int>(frequencyBands.bands.size());
-    if (numBands == 0) return;
+    // Draw traced frequency bands behind the spectrum
+    const int numBands = static_cast<int>(frequencyBands.bands.size());
     
-    float barWidth = bounds.getWidth() / numBands;
-    float maxBarHeight = bounds.getHeight() - 4;
-    
-    // Draw frequency band labels
-    g.setColour(juce::Colours::grey);
     g.setFont(juce::Font(10.0f));
     
     for (int i = 0; i < numBands; ++i)
     {
-        float x = bounds.getX() + i * barWidth;
-
-        float center = frequencyBands.bands[i].centerFrequency;
+        const auto& band = frequencyBands.bands[i];
+        float left = frequencyToX(band.minFrequency);
+        float right = frequencyToX(band.maxFrequency);
+        
+        if (showBands)
+        {
+            float value = juce::jlimit(0.0f, 1.0f, band.value);
+            float barHeight = value * spectrumBounds.getHeight();
+            
+            g.setColour(barColor.withAlpha(0.3f));
+            g.fillRect(left + 2, spectrumBounds.getBottom() - barHeight, right - left - 4, barHeight);
+        }
+        
+        float center = band.centerFrequency;
         if (center > 1000)
         {
             center /= 1000;
         }
-
-        juce::String freqLabel= juce::String::toDecimalStringWithSignificantFigures(center, 3);
         
-        g.drawText(freqLabel, 
-                  juce::Rectangle<float>(x, bounds.getBottom() - 12, barWidth, 12),
-                  juce::Justification::centred, false);
+        juce::String freqLabel = juce::String::toDecimalStringWithSignificantFigures(center, 3);
+        
+        g.setColour(juce::Colours::grey);
+        g.drawText(freqLabel,
+                   juce::Rectangle<float>(left, static_cast<float>(labelBounds.getY()), right - left, static_cast<float>(labelBounds.getHeight())),
+                   juce::Justification::centred, false);
     }
     
-    // Draw bars
-    g.setColour(barColor);
+    // Draw the spectrum curve
+    juce::Path spectrumPath;
     
-    for (int i = 0; i < numBands; ++i)
+    for (int bin = 0; bin < SpectrumAnalyser::NUM_BINS; ++bin)
     {
-        float value = juce::jlimit(0.0f, 1.0f, frequencyBands.bands[i].value);
-        float x = bounds.getX() + i * barWidth;
-        float barHeight = value * maxBarHeight;
+        float x = frequencyToX(SpectrumAnalyser::getBinFrequency(bin + 0.5f));
+        float y = levelToY(spectrum[static_cast<size_t>(bin)]);
         
-        g.fillRect(x + 2, bounds.getBottom() - barHeight - 14, barWidth - 4, barHeight);
+        if (bin == 0)
+            spectrumPath.startNewSubPath(x, y);
+        else
+            spectrumPath.lineTo(x, y);
     }
     
+    g.setColour(barColor);
+    g.strokePath(spectrumPath, juce::PathStrokeType(1.5f));
+    
     // Draw 0dB line
     g.setColour(juce::Colours::darkgrey);
-    g.drawHorizontalLine(bounds.getBottom() - 14, bounds.getX(), bounds.getRight());
+    g.drawHorizontalLine(spectrumBounds.getBottom(), spectrumBounds.getX(), spectrumBounds.getRight());
+    
+    // Draw the spectrogram
+    if (spectrogramImage.isValid())
+        g.drawImageAt(spectrogramImage, spectrogramBounds.getX(), spectrogramBounds.getY());
 }
 
 void FrequencyVisualizer::resized()
 {
     auto bounds = getLocalBounds();
     nameLabel.setBounds(bounds.removeFromTop(20).reduced(5, 0));
+    
+    auto plot = getLocalBounds().reduced(2, 20).withTrimmedTop(10);
+    labelBounds = plot.removeFromBottom(12);
+    spectrumBounds = plot.removeFromTop(plot.getHeight() / 2);
+    spectrogramBounds = plot.withTrimmedTop(2);
+    
+    // A resize starts the spectrogram afresh
+    if (spectrogramBounds.isEmpty())
+        spectrogramImage = juce::Image();
+    else
+        spectrogramImage = juce::Image(juce::Image::RGB, spectrogramBounds.getWidth(), spectrogramBounds.getHeight(), true);
 }
 
 void FrequencyVisualizer::updateFrequencyBands(const MicFrequencyBands& bands)
 {
     frequencyBands = bands;
+    showBands = true;
     repaint();
 }
 
+void FrequencyVisualizer::addSpectra(const SpectrumAnalyser::Spectrum* spectra, int numSpectra)
+{
+    if (numSpectra <= 0)
+        return;
+    
+    spectrum = spectra[numSpectra - 1];
+    
+    if (spectrogramImage.isValid())
+    {
+        const int width = spectrogramImage.getWidth();
+        const int numColumns = juce::jmin(numSpectra, width);
+        
+        // Scroll left and draw only the new columns on the right
+        spectrogramImage.moveImageSection(0, 0, numColumns, 0, width - numColumns, spectrogramImage.getHeight());
+        
+        for (int i = 0; i < numColumns; ++i)
+            drawSpectrogramColumn(spectra[numSpectra - numColumns + i], width - numColumns + i);
+    }
+    
+    repaint();
+}
+
+void FrequencyVisualizer::drawSpectrogramColumn(const SpectrumAnalyser::Spectrum& frame, int x)
+{
+    const int height = spectrogramImage.getHeight();
+    juce::Image::BitmapData pixels(spectrogramImage, x, 0, 1, height, juce::Image::BitmapData::writeOnly);
+    
+    for (int y = 0; y < height; ++y)
+    {
+        // Lowest frequencies at the bottom
+        const int bin = (height - 1 - y) * SpectrumAnalyser::NUM_BINS / height;
+        const float level = juce::jmap(frame[static_cast<size_t>(bin)], SpectrumAnalyser::MIN_DB, 0.0f, 0.0f, 1.0f);
+        
+        pixels.setPixelColour(0, y, barColor.withMultipliedBrightness(juce::jlimit(0.0f, 1.0f, level)));
+    }
+}
+
+float FrequencyVisualizer::frequencyToX(float frequency) const
+{
+    const float proportion = std::log(frequency / SpectrumAnalyser::MIN_FREQUENCY)
+                           / std::log(SpectrumAnalyser::MAX_FREQUENCY / SpectrumAnalyser::MIN_FREQUENCY);
+    
+    return spectrumBounds.getX() + juce::jlimit(0.0f, 1.0f, proportion) * spectrumBounds.getWidth();
+}
+
+float FrequencyVisualizer::levelToY(float levelDb) const
+{
+    return juce::jmap(juce::jlimit(SpectrumAnalyser::MIN_DB, 0.0f, levelDb),
+                      SpectrumAnalyser::MIN_DB, 0.0f,
+                      static_cast<float>(spectrumBounds.getBottom()), static_cast<float>(spectrumBounds.getY()));
+}
+
 void FrequencyVisualizer::setColor(const juce::Colour& color)
 {
     barColor = color;
@@ -2,9 +2,14 @@
 
 #include <JuceHeader.h>
 #include "../Models/MicFrequencyBands.h"
+#include "../DSP/SpectrumAnalyser.h"
 
 /**
- * Component that visualizes frequency band attenuation.
+ * Component that visualizes a live spectrum and spectrogram, optionally
+ * overlaid with the traced frequency band attenuation.
+ *
+ * Spectra come ready-to-draw from a SpectrumAnalyser; each new frame becomes
+ * one column of a scrolling spectrogram image, so only new columns are drawn.
  */
 class FrequencyVisualizer : public juce::Component
 {
@@ -16,11 +21,19 @@ public:
     void resized() override;
     
     /**
-     * Update the frequency band values
+     * Update the frequency band values shown behind the spectrum
      * @param bands Vector of frequency band values (typically 0.0 to 1.0)
      */
     void updateFrequencyBands(const MicFrequencyBands& bands);
     
+    /**
+     * Add analysed spectra; the newest is drawn as the spectrum curve and
+     * every frame is appended to the spectrogram
+     * @param spectra Frames to add, oldest first
+     * @param numSpectra Number of frames to add
+     */
+    void addSpectra(const SpectrumAnalyser::Spectrum* spectra, int numSpectra);
+    
     /**
      * Set the color of the frequency bars
      * @param color The color to use for the bars
@@ -34,11 +47,27 @@ public:
     void setName(const juce::String& name);
 
 private:
+    float frequencyToX(float frequency) const;
+    float levelToY(float levelDb) const;
+    void drawSpectrogramColumn(const SpectrumAnalyser::Spectrum& spectrum, int x);
+    
     juce::String displayName;
     juce::Colour barColor;
     
     // Frequency band data
     MicFrequencyBands frequencyBands;
+    bool showBands = false;
+    
+    // Latest spectrum
+    SpectrumAnalyser::Spectrum spectrum;
+    
+    // Layout
+    juce::Rectangle<int> spectrumBounds;
+    juce::Rectangle<int> spectrogramBounds;
+    juce::Rectangle<int> labelBounds;
+    
+    // Spectrogram, scrolled left one column per frame
+    juce::Image spectrogramImage;
     
     // UI elements
     juce::Label nameLabel;
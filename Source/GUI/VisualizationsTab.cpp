@@ -2,8 +2,9 @@
 
 #include <DebugLogger.h>
 
-VisualizationsTab::VisualizationsTab(Chamber& chamber)
-    : chamber(chamber),
+VisualizationsTab::VisualizationsTab(juce::AudioProcessor& processor, Chamber& chamber)
+    : processor(processor),
+      chamber(chamber),
       speakerWaveform("Speaker Input"),
       speakerFrequency("Speaker Frequency Response")
 {
@@ -32,6 +33,13 @@ VisualizationsTab::VisualizationsTab(Chamber& chamber)
         addAndMakeVisible(micFrequencies[i]);
     }
     
+    // Analyse the chamber input and each microphone output
+    inputSpectrumSource = analyser.addSource(chamber.getInputBuffer());
+    for (int i = 0; i < 3; ++i)
+    {
+        micSpectrumSources[i] = analyser.addSource(chamber.getOutputBuffer(i));
+    }
+    
     // Start visualizations
     startVisualizations();
 }
@@ -77,10 +85,46 @@ void VisualizationsTab::resized()
             area.removeFromTop(10);
         }
     }
+    
+    updateSamplesPerColumn();
+}
+
+double VisualizationsTab::getStreamSampleRate() const
+{
+    const double sampleRate = processor.getSampleRate();
+    return sampleRate > 0.0 ? sampleRate : 44100.0;
+}
+
+void VisualizationsTab::updateSamplesPerColumn()
+{
+    displayedSampleRate = getStreamSampleRate();
+    
+    // One summary column per pixel, so each waveform spans WAVEFORM_SECONDS
+    auto samplesPerColumn = [this](const WaveformVisualizer& waveform)
+    {
+        return static_cast<int>(displayedSampleRate * WAVEFORM_SECONDS / juce::jmax(1, waveform.getNumColumns()));
+    };
+    
+    chamber.getInputSummary().setSamplesPerColumn(samplesPerColumn(speakerWaveform));
+    
+    for (int i = 0; i < 3; ++i)
+    {
+        chamber.getOutputSummary(i).setSamplesPerColumn(samplesPerColumn(micWaveforms[i]));
+    }
 }
 
 void VisualizationsTab::timerCallback()
 {
+    // The host may re-prepare at another rate while the editor is open
+    if (getStreamSampleRate() != displayedSampleRate)
+    {
+        updateSamplesPerColumn();
+        
+        // The analyser's bin edges depend on the rate too
+        analyser.stop();
+        analyser.start(displayedSampleRate);
+    }
+    
     // Update frequency visualizers with the latest frequency responses
     const auto& micFrequencyResponses = chamber.getMicFrequencyResponses();
     
@@ -88,35 +132,32 @@ void VisualizationsTab::timerCallback()
     for (int i = 0; i < 3; ++i)
     {
         micFrequencies[i].updateFrequencyBands(micFrequencyResponses[i]);
+        
+        int readSpectra = analyser.readSpectra(micSpectrumSources[i], spectrumScratch.data(), static_cast<int>(spectrumScratch.size()));
+        micFrequencies[i].addSpectra(spectrumScratch.data(), readSpectra);
     }
     
-    // For speaker frequency, we'll use a flat response for now
-    MicFrequencyBands speakerBands = MicFrequencyBands();
-    speakerFrequency.updateFrequencyBands(speakerBands);
+    int readSpectra = analyser.readSpectra(inputSpectrumSource, spectrumScratch.data(), static_cast<int>(spectrumScratch.size()));
+    speakerFrequency.addSpectra(spectrumScratch.data(), readSpectra);
     
     // Update waveform visualizers
     
-    // For each microphone, get the most recent samples and add to visualizer
+    // For each microphone, pass on the summary columns produced since the last update
     for (int i = 0; i < 3; ++i)
     {
-        // Get the latest audio samples from the microphone buffers
-        std::vector<float> outputSamples;
-        outputSamples.resize(SAMPLES_PER_UPDATE);
-        int readSamples = chamber.getOutputBuffer(i).getSamples(outputSamples.data(), SAMPLES_PER_UPDATE);
-        micWaveforms[i].addSamples(outputSamples.data(), readSamples);
+        int readColumns = chamber.getOutputSummary(i).readColumns(columnScratch.data(), static_cast<int>(columnScratch.size()));
+        micWaveforms[i].addColumns(columnScratch.data(), readColumns);
     }
     
-    // For speaker waveform, we'll use a simple sine wave for now
-    std::vector<float> inputSamples;
-    inputSamples.resize(SAMPLES_PER_UPDATE);
-    int readSamples = chamber.getInputBuffer().getSamples(inputSamples.data(), SAMPLES_PER_UPDATE);
-    speakerWaveform.addSamples(inputSamples.data(), readSamples);
+    int readColumns = chamber.getInputSummary().readColumns(columnScratch.data(), static_cast<int>(columnScratch.size()));
+    speakerWaveform.addColumns(columnScratch.data(), readColumns);
 }
 
 void VisualizationsTab::startVisualizations()
 {
     // Start timer for updating visualizations
     startTimerHz(UPDATE_RATE_HZ);
+    analyser.start(getStreamSampleRate());
     
     // Start individual waveform visualizers
     speakerWaveform.startVisualization();
@@ -129,6 +170,7 @@ void VisualizationsTab::startVisualizations()
 void VisualizationsTab::stopVisualizations()
 {
     stopTimer();
+    analyser.stop();
     
     speakerWaveform.stopVisualization();
     for (auto& waveform : micWaveforms)
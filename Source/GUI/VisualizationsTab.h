@@ -3,6 +3,7 @@
 #include <JuceHeader.h>
 #include "WaveformVisualizer.h"
 #include "FrequencyVisualizer.h"
+#include "../DSP/SpectrumAnalyser.h"
 #include "../Models/Chamber.h"
 
 /**
@@ -12,7 +13,7 @@ class VisualizationsTab : public juce::Component,
                          private juce::Timer
 {
 public:
-    VisualizationsTab(Chamber& chamber);
+    VisualizationsTab(juce::AudioProcessor& processor, Chamber& chamber);
     ~VisualizationsTab() override;
     
     void paint(juce::Graphics&) override;
@@ -23,6 +24,7 @@ public:
     void stopVisualizations();
 
 private:
+    juce::AudioProcessor& processor;
     Chamber& chamber;
     
     // Speaker visualizers
@@ -33,9 +35,23 @@ private:
     std::array<WaveformVisualizer, 3> micWaveforms;
     std::array<FrequencyVisualizer, 3> micFrequencies;
     
+    // Spectra of the input and each microphone, computed on the analyser's thread
+    SpectrumAnalyser analyser;
+    int inputSpectrumSource;
+    std::array<int, 3> micSpectrumSources;
+    
     // Constants
     static constexpr int UPDATE_RATE_HZ = 30;
-    static constexpr int SAMPLES_PER_UPDATE = 10;
+    static constexpr double WAVEFORM_SECONDS = 2.0;   // Time span shown across each waveform
+
+    // The host's rate once playback has been prepared; the chamber streams run at it
+    double getStreamSampleRate() const;
+    double displayedSampleRate = 0.0;
+
+    void updateSamplesPerColumn();
+
+    std::array<WaveformColumn, WaveformSummariser::QUEUE_SIZE> columnScratch;
+    std::array<SpectrumAnalyser::Spectrum, SpectrumAnalyser::FRAME_QUEUE_SIZE> spectrumScratch;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VisualizationsTab)
 };
@@ -8,9 +8,6 @@ WaveformVisualizer::WaveformVisualizer(const juce::String& name)
     nameLabel.setFont(juce::Font(14.0f, juce::Font::bold));
     nameLabel.setJustificationType(juce::Justification::centredLeft);
     addAndMakeVisible(nameLabel);
-    
-    // Pre-fill the sample buffer with zeros
-    samples.resize(maxSamples, 0.0f);
 }
 
 WaveformVisualizer::~WaveformVisualizer()
@@ -28,90 +25,141 @@ void WaveformVisualizer::paint(juce::Graphics& g)
     g.drawRect(getLocalBounds(), 1);
     
     // Draw center line
-    auto bounds = getLocalBounds().reduced(2, 20).withTrimmedTop(10);
-    int centerY = bounds.getCentreY();
     g.setColour(juce::Colours::darkgrey);
-    g.drawHorizontalLine(centerY, bounds.getX(), bounds.getRight());
+    g.drawHorizontalLine(plotBounds.getCentreY(), plotBounds.getX(), plotBounds.getRight());
     
     // Draw waveform
-    g.setColour(waveformColor);
+    if (waveformImage.isValid())
+        g.drawImageAt(waveformImage, plotBounds.getX(), plotBounds.getY());
+}
+
+void WaveformVisualizer::resized()
+{
+    auto bounds = getLocalBounds();
+    nameLabel.setBounds(bounds.removeFromTop(20).reduced(5, 0));
     
-    float width = bounds.getWidth();
-    float height = bounds.getHeight();
-    float halfHeight = height / 2.0f;
+    plotBounds = getLocalBounds().reduced(2, 20).withTrimmedTop(10);
     
-    juce::Path waveformPath;
-    bool pathStarted = false;
+    // One column per pixel; a resize starts the display afresh
+    columns.assign(static_cast<size_t>(juce::jmax(1, plotBounds.getWidth())), WaveformColumn());
+    newestColumn = 0;
+    pendingColumns = 0;
+    redrawImage();
+}
+
+void WaveformVisualizer::timerCallback()
+{
+    if (pendingColumns > 0)
+    {
+        drawPendingColumns();
+        repaint();
+    }
+}
+
+void WaveformVisualizer::addColumns(const WaveformColumn* newColumns, int numColumns)
+{
+    if (columns.empty())
+        return;
     
-    // Draw samples
-    int numSamples = static_cast<int>(samples.size());
-    float xScale = width / numSamples;
+    const int size = static_cast<int>(columns.size());
     
-    for (int i = 0; i < numSamples; ++i)
+    for (int i = 0; i < numColumns; ++i)
     {
-        float x = bounds.getX() + i * xScale;
-        float y = centerY - samples[i] * halfHeight;
-        if (std::isnan(y))
-        {
-            y = 0;
-        }
-        
-        if (!pathStarted)
-        {
-            waveformPath.startNewSubPath(x, y);
-            pathStarted = true;
-        }
-        else
-        {
-            waveformPath.lineTo(x, y);
-        }
+        newestColumn = (newestColumn + 1) % size;
+        columns[static_cast<size_t>(newestColumn)] = newColumns[i];
     }
     
-    g.strokePath(waveformPath, juce::PathStrokeType(1.5f));
+    pendingColumns = juce::jmin(size, pendingColumns + numColumns);
 }
 
-void WaveformVisualizer::resized()
+int WaveformVisualizer::getNumColumns() const
 {
-    auto bounds = getLocalBounds();
-    nameLabel.setBounds(bounds.removeFromTop(20).reduced(5, 0));
+    return static_cast<int>(columns.size());
 }
 
-void WaveformVisualizer::timerCallback()
+void WaveformVisualizer::clear()
 {
+    std::fill(columns.begin(), columns.end(), WaveformColumn());
+    pendingColumns = 0;
+    redrawImage();
     repaint();
 }
 
-void WaveformVisualizer::addSample(float sample)
+void WaveformVisualizer::drawColumn(juce::Graphics& g, const WaveformColumn& column, int x) const
 {
-    // Add new sample and remove oldest if buffer is full
-    if (samples.size() >= maxSamples)
+    const float height = static_cast<float>(waveformImage.getHeight());
+    const float centreY = height / 2.0f;
+    
+    auto toY = [centreY](float value)
     {
-        samples.pop_front();
-    }
+        // Clamp sample value to prevent extreme values
+        value = std::isnan(value) ? 0.0f : juce::jlimit(-1.0f, 1.0f, value);
+        return centreY - value * centreY;
+    };
+    
+    const float top = toY(column.max);
+    const float bottom = juce::jmax(toY(column.min), top + 1.0f);
+    
+    g.setColour(waveformColor.withAlpha(0.6f));
+    g.drawVerticalLine(x, top, bottom);
     
-    // Clamp sample value to prevent extreme values
-    sample = juce::jlimit(-1.0f, 1.0f, sample);
-    samples.push_back(sample);
+    const float rmsTop = juce::jmax(top, toY(column.rms));
+    const float rmsBottom = juce::jmin(bottom, toY(-column.rms));
+    
+    if (rmsBottom > rmsTop)
+    {
+        g.setColour(waveformColor);
+        g.drawVerticalLine(x, rmsTop, rmsBottom);
+    }
 }
 
-void WaveformVisualizer::addSamples(const float* newSamples, int numSamples)
+void WaveformVisualizer::redrawImage()
 {
-    // Add multiple samples at once
-    for (int i = 0; i < numSamples; ++i)
+    if (plotBounds.isEmpty())
     {
-        addSample(newSamples[i]);
+        waveformImage = juce::Image();
+        return;
     }
+    
+    waveformImage = juce::Image(juce::Image::ARGB, plotBounds.getWidth(), plotBounds.getHeight(), true);
+    
+    juce::Graphics g(waveformImage);
+    const int size = static_cast<int>(columns.size());
+    
+    for (int x = 0; x < size; ++x)
+        drawColumn(g, columns[static_cast<size_t>((newestColumn + 1 + x) % size)], x);
+    
+    pendingColumns = 0;
 }
 
-void WaveformVisualizer::clear()
+void WaveformVisualizer::drawPendingColumns()
 {
-    samples.clear();
-    samples.resize(maxSamples, 0.0f);
+    if (!waveformImage.isValid())
+        return;
+    
+    const int width = waveformImage.getWidth();
+    const int height = waveformImage.getHeight();
+    const int size = static_cast<int>(columns.size());
+    
+    // Scroll the existing columns left and clear the strip for the new ones
+    waveformImage.moveImageSection(0, 0, pendingColumns, 0, width - pendingColumns, height);
+    waveformImage.clear({ width - pendingColumns, 0, pendingColumns, height });
+    
+    juce::Graphics g(waveformImage);
+    
+    for (int i = 0; i < pendingColumns; ++i)
+    {
+        const int columnIndex = (newestColumn - pendingColumns + 1 + i + size) % size;
+        drawColumn(g, columns[static_cast<size_t>(columnIndex)], width - pendingColumns + i);
+    }
+    
+    pendingColumns = 0;
 }
 
 void WaveformVisualizer::setColor(const juce::Colour& color)
 {
     waveformColor = color;
+    redrawImage();
     repaint();
 }
 
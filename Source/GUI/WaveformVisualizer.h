@@ -1,10 +1,15 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <deque>
+#include <vector>
+#include "../DSP/WaveformSummariser.h"
 
 /**
  * Component that visualizes an audio waveform over time.
+ *
+ * The waveform is fed pre-decimated min/max/RMS columns (see WaveformSummariser),
+ * one per pixel of width. Columns are rendered into a scrolling image and only
+ * the columns that arrived since the last frame are drawn.
  */
 class WaveformVisualizer : public juce::Component,
                           public juce::Timer
@@ -17,20 +22,20 @@ public:
     void timerCallback() override;
     
     /**
-     * Add a new sample to the waveform buffer
-     * @param sample The audio sample value (-1.0 to 1.0)
+     * Append summary columns to the right-hand side of the display
+     * @param newColumns Columns to add, oldest first
+     * @param numColumns Number of columns to add
      */
-    void addSample(float sample);
+    void addColumns(const WaveformColumn* newColumns, int numColumns);
     
     /**
-     * Add multiple samples to the waveform buffer
-     * @param samples Array of samples to add
-     * @param numSamples Number of samples to add
+     * Get the number of columns the display currently shows (its plot width in pixels)
+     * @return The number of columns
      */
-    void addSamples(const float* samples, int numSamples);
+    int getNumColumns() const;
     
     /**
-     * Clear all samples from the buffer
+     * Clear all columns from the display
      */
     void clear();
     
@@ -61,9 +66,18 @@ private:
     juce::String displayName;
     juce::Colour waveformColor;
     
-    // Buffer for waveform data
-    std::deque<float> samples;
-    const int maxSamples = 1024;
+    void drawColumn(juce::Graphics& g, const WaveformColumn& column, int x) const;
+    void redrawImage();
+    void drawPendingColumns();
+    
+    // Ring of the columns on screen; newestColumn indexes the most recent one
+    std::vector<WaveformColumn> columns;
+    int newestColumn = 0;
+    
+    // Rendered columns, scrolled left as new columns arrive
+    juce::Rectangle<int> plotBounds;
+    juce::Image waveformImage;
+    int pendingColumns = 0;
     
     // UI elements
     juce::Label nameLabel;
@@ -1,7 +1,7 @@
 #include "ZoneManager.h"
 
 ZoneManager::ZoneManager(Chamber& c)
-    : chamber(c)
+    : chamber(&c)
 {
     addZoneButton = std::make_unique<juce::TextButton>("Add Zone");
     addZoneButton->addListener(this);
@@ -13,18 +13,7 @@ ZoneManager::~ZoneManager()
     addZoneButton->removeListener(this);
     
     // Remove listeners from all controls
-    for (auto* slider : densitySliders)
-        slider->removeListener(this);
-    for (auto* slider : x1Sliders)
-        slider->removeListener(this);
-    for (auto* slider : y1Sliders)
-        slider->removeListener(this);
-    for (auto* slider : x2Sliders)
-        slider->removeListener(this);
-    for (auto* slider : y2Sliders)
-        slider->removeListener(this);
-    for (auto* button : removeButtons)
-        button->removeListener(this);
+    clearZoneControls();
 }
 
 void ZoneManager::paint(juce::Graphics& g)
@@ -142,6 +131,49 @@ void ZoneManager::sliderValueChanged(juce::Slider* slider)
     }
 }
 
+void ZoneManager::sliderDragStarted(juce::Slider*)
+{
+    // Progressive retracing while dragging, and one undo step per drag
+    if (!gestureOpen)
+        chamber->beginGesture();
+    gestureOpen = true;
+}
+
+void ZoneManager::sliderDragEnded(juce::Slider*)
+{
+    endOpenGesture();
+}
+
+void ZoneManager::endOpenGesture()
+{
+    if (gestureOpen)
+        chamber->endGesture();
+    gestureOpen = false;
+}
+
+void ZoneManager::setChamber(Chamber& chamberToManage)
+{
+    if (&chamberToManage == chamber)
+        return;
+    
+    endOpenGesture();
+    chamber = &chamberToManage;
+    syncWithChamber();
+}
+
+void ZoneManager::syncWithChamber()
+{
+    clearZoneControls();
+    
+    for (const auto& zone : chamber->getZones())
+    {
+        if (zone != nullptr)
+            addZoneControls(*zone);
+    }
+    
+    resized();
+}
+
 void ZoneManager::addNewZone()
 {
     // Create zone in chamber with default values
@@ -151,7 +183,19 @@ void ZoneManager::addNewZone()
     float defaultHeight = 0.2f;
     float defaultDensity = 2.0f;
     
-    chamber.addZone(defaultX, defaultY, defaultWidth, defaultHeight, defaultDensity);
+    chamber->checkpointGeometry();
+    
+    // Adding the zone and initialising its sliders is one scene edit
+    Chamber::ScopedEdit sceneEdit(*chamber);
+    
+    int zoneIndex = chamber->addZone(defaultX, defaultY, defaultWidth, defaultHeight, defaultDensity);
+    addZoneControls(*chamber->getZones()[zoneIndex]);
+    
+    resized();
+}
+
+void ZoneManager::addZoneControls(const Zone& zone)
+{
     int zoneId = removeButtons.size(); // Use the current number of zone controls
     
     // Create controls
@@ -167,7 +211,7 @@ void ZoneManager::addNewZone()
     densitySlider->setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     densitySlider->setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
     densitySlider->setRange(0.1, 10.0);
-    densitySlider->setValue(1.0);
+    densitySlider->setValue(zone.density, juce::dontSendNotification);
     densitySlider->addListener(this);
     addAndMakeVisible(densitySlider.get());
     
@@ -176,12 +220,13 @@ void ZoneManager::addNewZone()
     positionLabel->setJustificationType(juce::Justification::centred);
     addAndMakeVisible(positionLabel.get());
     
-    // Create position sliders
-    auto createPosSlider = [this]() {
+    // Create position sliders showing the zone's current bounds
+    auto createPosSlider = [this](float value) {
         auto slider = std::make_unique<juce::Slider>();
         slider->setSliderStyle(juce::Slider::LinearHorizontal);
         slider->setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
         slider->setRange(0.0, 1.0);
+        slider->setValue(value, juce::dontSendNotification);
         slider->addListener(this);
         addAndMakeVisible(slider.get());
         return slider;
@@ -190,26 +235,22 @@ void ZoneManager::addNewZone()
     auto x1Label = std::make_unique<juce::Label>();
     x1Label->setText("X1", juce::dontSendNotification);
     addAndMakeVisible(x1Label.get());
-    auto x1Slider = createPosSlider();
-    x1Slider->setValue(0.25);
+    auto x1Slider = createPosSlider(zone.x);
     
     auto y1Label = std::make_unique<juce::Label>();
     y1Label->setText("Y1", juce::dontSendNotification);
     addAndMakeVisible(y1Label.get());
-    auto y1Slider = createPosSlider();
-    y1Slider->setValue(0.25);
+    auto y1Slider = createPosSlider(zone.y);
     
     auto x2Label = std::make_unique<juce::Label>();
     x2Label->setText("X2", juce::dontSendNotification);
     addAndMakeVisible(x2Label.get());
-    auto x2Slider = createPosSlider();
-    x2Slider->setValue(0.75);
+    auto x2Slider = createPosSlider(zone.x + zone.width);
     
     auto y2Label = std::make_unique<juce::Label>();
     y2Label->setText("Y2", juce::dontSendNotification);
     addAndMakeVisible(y2Label.get());
-    auto y2Slider = createPosSlider();
-    y2Slider->setValue(0.75);
+    auto y2Slider = createPosSlider(zone.y + zone.height);
     
     // Store controls
     removeButtons.add(removeButton.release());
@@ -224,8 +265,38 @@ void ZoneManager::addNewZone()
     x2Sliders.add(x2Slider.release());
     y2Labels.add(y2Label.release());
     y2Sliders.add(y2Slider.release());
+}
+
+void ZoneManager::clearZoneControls()
+{
+    // A slider destroyed mid-drag never reports the end of its drag
+    endOpenGesture();
     
-    resized();
+    for (auto* slider : densitySliders)
+        slider->removeListener(this);
+    for (auto* slider : x1Sliders)
+        slider->removeListener(this);
+    for (auto* slider : y1Sliders)
+        slider->removeListener(this);
+    for (auto* slider : x2Sliders)
+        slider->removeListener(this);
+    for (auto* slider : y2Sliders)
+        slider->removeListener(this);
+    for (auto* button : removeButtons)
+        button->removeListener(this);
+    
+    removeButtons.clear();
+    densityLabels.clear();
+    densitySliders.clear();
+    positionLabels.clear();
+    x1Labels.clear();
+    x1Sliders.clear();
+    y1Labels.clear();
+    y1Sliders.clear();
+    x2Labels.clear();
+    x2Sliders.clear();
+    y2Labels.clear();
+    y2Sliders.clear();
 }
 
 void ZoneManager::removeZone(int index)
@@ -233,7 +304,8 @@ void ZoneManager::removeZone(int index)
     if (index >= 0 && index < removeButtons.size())
     {
         // Remove zone from chamber
-        chamber.removeZone(index);
+        chamber->checkpointGeometry();
+        chamber->removeZone(index);
         
         // Remove controls
         removeButtons.remove(index);
@@ -257,7 +329,7 @@ void ZoneManager::updateZoneDensity(int index, float density)
 {
     if (index >= 0 && index < densitySliders.size())
     {
-        chamber.setZoneDensity(index, density);
+        chamber->setZoneDensity(index, density);
     }
 }
 
@@ -271,6 +343,6 @@ void ZoneManager::updateZoneBounds(int index, float x1, float y1, float x2, floa
         float width = x2 - x1;
         float height = y2 - y1;
         
-        chamber.setZoneBounds(index, x, y, width, height);
+        chamber->setZoneBounds(index, x, y, width, height);
     }
 }
@@ -23,14 +23,26 @@ public:
     
     // Slider::Listener
     void sliderValueChanged(juce::Slider* slider) override;
+    void sliderDragStarted(juce::Slider* slider) override;
+    void sliderDragEnded(juce::Slider* slider) override;
+    
+    // Rebuild the zone controls from the chamber, e.g. after an undo
+    void syncWithChamber();
+    
+    // Manage another chamber's zones, e.g. another channel's in a multichannel layout
+    void setChamber(Chamber& chamberToManage);
 
 private:
     void addNewZone();
+    void addZoneControls(const Zone& zone);
+    void clearZoneControls();
+    void endOpenGesture();
     void removeZone(int index);
     void updateZoneDensity(int index, float density);
     void updateZoneBounds(int index, float x1, float y1, float x2, float y2);
     
-    Chamber& chamber;
+    Chamber* chamber;
+    bool gestureOpen = false;     // a slider drag has begun a chamber gesture
     
     std::unique_ptr<juce::TextButton> addZoneButton;
     
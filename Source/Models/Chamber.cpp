@@ -1,110 +1,504 @@
 #include "Chamber.h"
 #include "../DebugLogger.h"
-
-// Define M_PI if not already defined
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include <limits>
 
 // Constructor
 Chamber::Chamber()
-    : speakerX(0.5f),
-      speakerY(0.5f),
-      initialized(false),
+    : initialized(false),
       sampleRate(44100.0),
-      currentBlockSize(0),
-      currentSampleIndex(0),
-      samplesSinceLastFFT(0),
-      minSamplesForFFT(0), // Will be calculated in initialize()
-      bypassProcessing(false), // Initialize to false by default
-      fftSize(1024),
-      fftBufferPos(0),
-      defaultMediumDensity(1.0f) // Initialize default medium density
+      defaultMediumDensity(1.0f), // Initialize default medium density
+      wallReflectivity(0.5f),
+      wallDamping(0.2f)
 {
-    DebugLogger::logWithCategory("CHAMBER", "Chamber constructor called");
+    RIPPLE_LOG(Chamber, Debug, "Chamber constructor called");
+
+    speakers.push_back({ 0.5f, 0.5f });
 
     // Initialize microphone positions
     micPositions[0] = juce::Point<float>(0.2f, 0.2f);
     micPositions[1] = juce::Point<float>(0.8f, 0.2f);
     micPositions[2] = juce::Point<float>(0.5f, 0.8f);
+
+    rayTracer = std::make_unique<RayTracer>();
+    rayTracer->initialize(this);
+    
+    startTimer(EVALUATION_POLL_MS);
+    
+    RIPPLE_LOG(Chamber, Debug, "Chamber constructor completed");
+}
+
+Chamber::~Chamber()
+{
+    stopTimer();
+    cancelPendingUpdate();
+}
+
+void Chamber::beginEdit()
+{
+    ++editDepth;
+}
+
+void Chamber::commitEdit()
+{
+    jassert(editDepth > 0);
+    editDepth = juce::jmax(0, editDepth.load() - 1);
+    
+    if (editDepth == 0 && (sceneDirty || parametersDirty))
+        scheduleEvaluation();
+}
+
+void Chamber::markSceneDirty()
+{
+    sceneDirty = true;
+    
+    // Inside a transaction the evaluation is scheduled by commitEdit()
+    if (editDepth == 0)
+        scheduleEvaluation();
+}
+
+void Chamber::markParametersDirty()
+{
+    parametersDirty = true;
+    
+    if (editDepth == 0)
+        scheduleEvaluation();
+}
+
+void Chamber::scheduleEvaluation()
+{
+    // Automation may arrive on the audio thread, which only leaves a note
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        triggerAsyncUpdate();
+    else
+        evaluationRequested.store(true, std::memory_order_release);
+}
+
+void Chamber::timerCallback()
+{
+    if (evaluationRequested.exchange(false, std::memory_order_acquire))
+        handleAsyncUpdate();
+}
+
+void Chamber::evaluate()
+{
+    if ((!sceneDirty && !parametersDirty) || editDepth > 0)
+        return;
+    
+    cancelPendingUpdate();
     
-    // Initialize microphone buffers
-    for (int i = 0; i < 3; ++i) {
-        micBuffers[i].resize(1024, 0.0f);
-        micFFTData[i].resize(FFT_SIZE, std::complex<float>(0.0f, 0.0f));
-        previousPhase[i].resize(FFT_SIZE, 0.0f);
+    // Wall and medium values don't move any paths, so replay them if the tracer can
+    if (!sceneDirty)
+    {
+        parametersDirty = false;
+        if (rayTracer->replayParameters())
+            return;
     }
     
-    // Initialize FFT-related members
-    fftInputBuffer.resize(FFT_SIZE, 0.0f);
-    fftWorkspace.resize(FFT_SIZE, std::complex<float>(0.0f, 0.0f));
-    fftData.resize(FFT_SIZE * 2, 0.0f); // Double size for real/imaginary parts
-    fftOutput.resize(FFT_SIZE, 0.0f);
-    windowFunction.resize(FFT_SIZE, 0.0f);
+    RIPPLE_LOG(Chamber, Debug, "Evaluating changed scene");
+    
+    // Clear first: an edit made while tracing marks the scene dirty again
+    sceneDirty = false;
+    parametersDirty = false;
+    
+    //Recalc rays and store frequency responses
+    if (interactiveGestures > 0)
+        rayTracer->updateRayCacheProgressively();
+    else
+        rayTracer->updateRayCache();
+}
+
+void Chamber::beginGesture()
+{
+    if (interactiveGestures++ == 0)
+        gestureStartGeometry = captureGeometry();
+}
+
+void Chamber::endGesture()
+{
+    jassert(interactiveGestures > 0);
     
-    // Create Hann window function
-    for (int i = 0; i < FFT_SIZE; ++i) {
-        windowFunction[i] = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (FFT_SIZE - 1)));
+    // The last refinement stage is already a full-depth trace, so only edits
+    // still pending when the gesture ends need evaluating
+    if (--interactiveGestures == 0)
+    {
+        // A click that moved nothing is not an undo step
+        const bool moved = captureGeometry() != gestureStartGeometry;
+        if (moved)
+            pushUndoStep(std::move(gestureStartGeometry));
+        
+        evaluate();
+        
+        // Only where the drag came to rest is worth keeping on disk
+        if (moved && !isSceneDirty())
+            rayTracer->persistCurrentScene();
     }
+}
+
+void Chamber::checkpointGeometry()
+{
+    pushUndoStep(captureGeometry());
+}
+
+bool Chamber::undoGeometry()
+{
+    if (undoHistory.empty() || interactiveGestures > 0)
+        return false;
+    
+    RIPPLE_LOG(Chamber, Debug, "Undoing geometry change ({} steps left)", static_cast<int>(undoHistory.size() - 1));
     
-    // Initialize FFT objects
-    fftForward = std::make_unique<juce::dsp::FFT>(std::log2(FFT_SIZE));
-    fftInverse = std::make_unique<juce::dsp::FFT>(std::log2(FFT_SIZE));
+    redoHistory.push_back(captureGeometry());
+    restoreGeometry(undoHistory.back());
+    undoHistory.pop_back();
+    
+    // Publish now rather than on the next message loop; a revisited layout is a cache hit
+    evaluate();
+    return true;
+}
 
-    rayTracer = std::make_unique<RayTracer>();
-    rayTracer->initialize(this);
+bool Chamber::redoGeometry()
+{
+    if (redoHistory.empty() || interactiveGestures > 0)
+        return false;
+    
+    RIPPLE_LOG(Chamber, Debug, "Redoing geometry change ({} steps left)", static_cast<int>(redoHistory.size() - 1));
+    
+    undoHistory.push_back(captureGeometry());
+    restoreGeometry(redoHistory.back());
+    redoHistory.pop_back();
     
-    DebugLogger::logWithCategory("CHAMBER", "Chamber constructor completed");
+    // Publish now rather than on the next message loop; a revisited layout is a cache hit
+    evaluate();
+    return true;
 }
 
-Chamber::~Chamber()
+void Chamber::pushUndoStep(Geometry geometry)
 {
-    // Clean up any resources
+    if (!undoHistory.empty() && undoHistory.back() == geometry)
+        return;
+    
+    undoHistory.push_back(std::move(geometry));
+    redoHistory.clear();
+    
+    if (undoHistory.size() > MAX_UNDO_STEPS)
+        undoHistory.erase(undoHistory.begin());
 }
 
-void Chamber::initialize(float speakerX, float speakerY)
+Chamber::Geometry Chamber::captureGeometry() const
 {
-    DebugLogger::logWithCategory("CHAMBER", "Chamber initialize called with sampleRate: " + 
-                                 std::to_string(sampleRate) + ", speakerX: " + 
-                                 std::to_string(speakerX) + ", speakerY: " + 
-                                 std::to_string(speakerY));
-    setSpeakerPosition(speakerX, speakerY);
+    Geometry geometry;
+    geometry.speakers = speakers;
+    geometry.microphones = micPositions;
     
-    // Calculate minimum samples needed for FFT processing
-    // For a good frequency resolution down to 50Hz, we need at least sampleRate / 50 samples
-    // But we also want to keep latency low, so we'll use a fraction of that
-    minSamplesForFFT = static_cast<int>(sampleRate / 50.0 / 4.0); // 1/4 of the samples needed for 50Hz resolution
+    geometry.zones.reserve(zones.size());
+    for (const auto& zone : zones)
+    {
+        if (zone != nullptr)
+            geometry.zones.push_back(*zone);
+    }
     
-    // Ensure it's not too small or too large
-    minSamplesForFFT = juce::jlimit(256, FFT_SIZE / 2, minSamplesForFFT);
+    return geometry;
+}
+
+void Chamber::restoreGeometry(const Geometry& geometry)
+{
+    {
+        ScopedEdit edit(*this);
+        
+        speakers = geometry.speakers;
+        micPositions = geometry.microphones;
+        
+        zones.clear();
+        for (const auto& zone : geometry.zones)
+            zones.push_back(std::make_unique<Zone>(zone));
+        
+        markSceneDirty();
+    }
+}
+
+void Chamber::writeScene(juce::OutputStream& stream) const
+{
+    stream.writeCompressedInt(SCENE_FORMAT_VERSION);
+    
+    stream.writeCompressedInt(static_cast<int>(speakers.size()));
+    for (const auto& speaker : speakers)
+    {
+        stream.writeFloat(speaker.x);
+        stream.writeFloat(speaker.y);
+    }
+    for (const auto& mic : micPositions)
+    {
+        stream.writeFloat(mic.x);
+        stream.writeFloat(mic.y);
+    }
+    
+    const auto geometry = captureGeometry();
+    stream.writeCompressedInt(static_cast<int>(geometry.zones.size()));
+    for (const auto& zone : geometry.zones)
+    {
+        stream.writeFloat(zone.x);
+        stream.writeFloat(zone.y);
+        stream.writeFloat(zone.width);
+        stream.writeFloat(zone.height);
+        stream.writeFloat(zone.density);
+    }
     
-    DebugLogger::logWithCategory("CHAMBER", "Minimum samples for FFT set to: " + std::to_string(minSamplesForFFT));
+    // Responses of a dirty scene belong to an older layout, and those of an
+    // inactive mic may too
+    bool withResponses = initialized && !isSceneDirty() && rayTracer->getNumSpeakers() == getNumSpeakers();
+    for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+        withResponses = withResponses && rayTracer->isMicrophoneCurrent(mic);
     
-    // Reset FFT sample counter
-    samplesSinceLastFFT = 0;
+    stream.writeBool(withResponses);
+    if (withResponses)
+    {
+        for (int speaker = 0; speaker < getNumSpeakers(); ++speaker)
+        {
+            for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+            {
+                for (const auto value : rayTracer->getAppliedResponse(speaker, mic))
+                    stream.writeFloat(value);
+            }
+        }
+    }
+}
 
-    //Recalc rays and store frequency responses
-    rayTracer->updateRayCache();
+bool Chamber::readScene(juce::InputStream& stream)
+{
+    constexpr int NUM_BANDS = MicFrequencyBands::NUM_FREQUENCY_BANDS;
+    constexpr int64_t POINT_SIZE = 2 * sizeof(float);
+    constexpr int64_t ZONE_SIZE = 5 * sizeof(float);
+    constexpr int64_t SPEAKER_RESPONSES_SIZE = NUM_MICROPHONES * NUM_BANDS * sizeof(float);
+    
+    const int version = stream.readCompressedInt();
+    if (version < 1 || version > SCENE_FORMAT_VERSION)
+    {
+        RIPPLE_LOG(Chamber, Warning, "Unsupported scene format version {}", version);
+        return false;
+    }
+    
+    // Version 1 stored a single speaker without a count
+    const int numSpeakers = version >= 2 ? stream.readCompressedInt() : 1;
+    if (numSpeakers < 1 || numSpeakers > MAX_SPEAKERS
+        || stream.getNumBytesRemaining() < (numSpeakers + NUM_MICROPHONES) * POINT_SIZE)
+        return false;
+    
+    const auto readPoint = [&stream]
+    {
+        const float x = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        const float y = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        return juce::Point<float>(x, y);
+    };
+    
+    Geometry geometry;
+    geometry.speakers.resize(static_cast<size_t>(numSpeakers));
+    for (auto& speaker : geometry.speakers)
+        speaker = readPoint();
+    for (auto& mic : geometry.microphones)
+        mic = readPoint();
+    
+    const int numZones = stream.readCompressedInt();
+    if (numZones < 0 || numZones > MAX_SAVED_ZONES || stream.getNumBytesRemaining() < numZones * ZONE_SIZE)
+        return false;
+    
+    geometry.zones.reserve(static_cast<size_t>(numZones));
+    for (int i = 0; i < numZones; ++i)
+    {
+        Zone zone;
+        zone.x = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        zone.y = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        zone.width = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        zone.height = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        zone.density = stream.readFloat();
+        geometry.zones.push_back(zone);
+    }
+    
+    std::vector<RayTracer::MicBandValues> responses;
+    const bool withResponses = stream.readBool();
+    if (withResponses)
+    {
+        if (stream.getNumBytesRemaining() < numSpeakers * SPEAKER_RESPONSES_SIZE)
+            return false;
+        
+        responses.resize(static_cast<size_t>(numSpeakers));
+        for (auto& speakerResponses : responses)
+        {
+            for (auto& response : speakerResponses)
+            {
+                for (auto& value : response)
+                    value = stream.readFloat();
+            }
+        }
+    }
+    
+    if (geometry == captureGeometry())
+    {
+        RIPPLE_LOG(Chamber, Debug, "Restored scene matches the current one");
+        return true;
+    }
+    
+    RIPPLE_LOG(Chamber, Debug, "Restoring scene with {} speakers and {} zones", numSpeakers, numZones);
+    restoreGeometry(geometry);
+    
+    // The saved responses stand in for a trace of the restored layout (and
+    // of the parameters restored with it), so nothing is retraced until the
+    // next edit
+    if (withResponses && initialized && rayTracer->publishBakedResponses(responses))
+    {
+        sceneDirty = false;
+        parametersDirty = false;
+    }
+    
+    sceneRestoreCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void Chamber::handleAsyncUpdate()
+{
+    evaluate();
+    startRequestedMicrophones();
+}
+
+void Chamber::initialize()
+{
+    RIPPLE_LOG(Chamber, Debug, "Chamber initialize called with sampleRate: {}", sampleRate);
+
+    // Retrace when the result is first needed. Re-preparing keeps the current
+    // result: only the filter coefficients depend on the sample rate.
+    if (!initialized)
+        markSceneDirty();
     
     initialized = true;
     
-    DebugLogger::logWithCategory("CHAMBER", "Chamber initialization completed");
+    RIPPLE_LOG(Chamber, Debug, "Chamber initialization completed");
+}
+
+void Chamber::prepare(int maximumBlockSize)
+{
+    RIPPLE_LOG(Chamber, Debug, "Preparing chamber buffers for {} samples", maximumBlockSize);
+    
+    speakerBuffer.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), 0.0f);
+    for (auto& lane : micLanes)
+        lane.speakerOutput.assign(speakerBuffer.size(), 0.0f);
+    preRollBuffer.assign(PRE_ROLL_SAMPLES, 0.0f);
+    preRollOutput.assign(PRE_ROLL_SAMPLES, 0.0f);
+}
+
+void Chamber::setParallelProcessingEnabled(bool enabled)
+{
+    if (enabled == (fanOut != nullptr))
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Parallel microphone processing {}", enabled ? "enabled" : "disabled");
+    
+    if (enabled)
+        fanOut = std::make_unique<juce::SharedResourcePointer<BlockFanOut>>();
+    else
+        fanOut.reset();
+}
+
+void Chamber::setTransferFieldEnabled(bool enabled)
+{
+    RIPPLE_LOG(Chamber, Debug, "Transfer field {}", enabled ? "enabled" : "disabled");
+    rayTracer->setTransferFieldEnabled(enabled);
+}
+
+void Chamber::setMicrophoneActive(int index, bool active)
+{
+    if (index < 0 || index >= NUM_MICROPHONES)
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Microphone {} {}", index, active ? "active" : "inactive");
+    
+    const auto bit = 1u << index;
+    
+    if (!active)
+    {
+        requestedMicrophones.fetch_and(~bit);
+        activeMicrophones.fetch_and(~bit, std::memory_order_release);
+        return;
+    }
+    
+    if ((requestedMicrophones.fetch_or(bit) & bit) != 0)
+        return;
+    
+    // Responses are only ever computed on the message thread; elsewhere
+    // (e.g. automated solo/mute on the audio thread) the timer starts it
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        startRequestedMicrophones();
+    else
+        evaluationRequested.store(true, std::memory_order_release);
+}
+
+void Chamber::startRequestedMicrophones()
+{
+    const auto pending = requestedMicrophones.load() & ~activeMicrophones.load();
+    
+    for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+    {
+        const auto bit = 1u << mic;
+        if ((pending & bit) == 0)
+            continue;
+        
+        // Bring the response up to date before the audio thread can see the
+        // microphone (a pending evaluation will include it anyway)
+        if (!sceneDirty)
+            rayTracer->updateMicrophone(mic);
+        
+        activeMicrophones.fetch_or(bit, std::memory_order_release);
+        
+        // Switched off again meanwhile, e.g. by automation on the audio thread
+        if ((requestedMicrophones.load() & bit) == 0)
+            activeMicrophones.fetch_and(~bit, std::memory_order_release);
+    }
+}
+
+bool Chamber::isMicrophoneActive(int index) const
+{
+    return (requestedMicrophones.load(std::memory_order_relaxed) & (1u << index)) != 0;
+}
+
+int Chamber::addSpeaker(float x, float y)
+{
+    if (getNumSpeakers() >= MAX_SPEAKERS)
+        return -1;
+    
+    RIPPLE_LOG(Chamber, Debug, "Adding speaker {} at ({}, {})", speakers.size(), x, y);
+    
+    speakers.push_back({ juce::jlimit(0.0f, 1.0f, x), juce::jlimit(0.0f, 1.0f, y) });
+
+    // Retrace when the result is next needed
+    markSceneDirty();
+    return getNumSpeakers() - 1;
+}
+
+void Chamber::removeSpeaker(int index)
+{
+    if (index < 0 || index >= getNumSpeakers() || getNumSpeakers() == 1)
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Removing speaker {}", index);
+    
+    speakers.erase(speakers.begin() + index);
+
+    // Retrace when the result is next needed
+    markSceneDirty();
 }
 
-void Chamber::setSpeakerPosition(float x, float y)
+void Chamber::setSpeakerPosition(int index, float x, float y)
 {
-    DebugLogger::logWithCategory("CHAMBER", "Setting speaker position to (" + 
-                                 std::to_string(x) + ", " + std::to_string(y) + ")");
+    if (index < 0 || index >= getNumSpeakers())
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Setting speaker {} position to ({}, {})", index, x, y);
     
     // Clamp to 0-1 range
     x = juce::jlimit(0.0f, 1.0f, x);
     y = juce::jlimit(0.0f, 1.0f, y);
     
-    speakerX = x;
-    speakerY = y;
+    speakers[static_cast<size_t>(index)] = { x, y };
 
-    //Recalc rays and store frequency responses
-    rayTracer->updateRayCache();
+    // Retrace when the result is next needed
+    markSceneDirty();
 }
 
 void Chamber::setMicrophonePosition(int index, float x, float y)
@@ -112,9 +506,7 @@ void Chamber::setMicrophonePosition(int index, float x, float y)
     if (index < 0 || index >= 3)
         return;
     
-    DebugLogger::logWithCategory("CHAMBER", "Setting microphone " + std::to_string(index) + 
-                                 " position to (" + std::to_string(x) + ", " + 
-                                 std::to_string(y) + ")");
+    RIPPLE_LOG(Chamber, Debug, "Setting microphone {} position to ({}, {})", index, x, y);
     
     // Clamp to 0-1 range
     x = juce::jlimit(0.0f, 1.0f, x);
@@ -122,258 +514,311 @@ void Chamber::setMicrophonePosition(int index, float x, float y)
     
     micPositions[index] = {x, y};
 
-    //Recalc rays and store frequency responses
-    rayTracer->updateRayCache();
-}
+    // With a transfer field for the current layout a mic move is a lookup.
+    // The ray paths drawn by the visualizer stay as traced.
+    if (!sceneDirty && rayTracer->updateMicrophoneFromTransferField(index))
+        return;
 
-void Chamber::setBypassProcessing(bool bypass)
-{
-    bypassProcessing = bypass;
+    // Retrace when the result is next needed
+    markSceneDirty();
 }
 
 void Chamber::setSampleRate(double sampleRate)
 {
-    return;
-    double previousSampleRate = this->sampleRate;
+    if (sampleRate <= 0.0 || sampleRate == this->sampleRate)
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Setting sample rate to {} from {}", sampleRate, this->sampleRate);
     this->sampleRate = sampleRate;
-    if (previousSampleRate != sampleRate)
-    {
-        DebugLogger::logWithCategory("CHAMBER", "Setting sample rate to " + std::to_string(sampleRate) + " from " + std::to_string(previousSampleRate));
-        rayTracer->updateRayCache();
-    }
+    
+    // The traced paths don't depend on the rate
+    rayTracer->updateSampleRate();
 }
 
 
-void Chamber::processBlock(const float* input, int numSamples)
+void Chamber::process(const juce::dsp::AudioBlock<const float>& input, const juce::dsp::AudioBlock<float>& micOutputs)
 {
+    jassert(micOutputs.getNumChannels() >= static_cast<size_t>(NUM_MICROPHONES));
+    
+    int numSamples = static_cast<int>(juce::jmin(input.getNumSamples(), micOutputs.getNumSamples()));
+    
+    std::array<float*, NUM_MICROPHONES> outputs;
+    for (int i = 0; i < NUM_MICROPHONES; ++i)
+    {
+        outputs[i] = micOutputs.getChannelPointer(static_cast<size_t>(i));
+    }
+    
+    auto clearOutputs = [&outputs, numSamples]
+    {
+        for (auto* output : outputs)
+        {
+            juce::FloatVectorOperations::clear(output, numSamples);
+        }
+    };
+    
     if (!initialized)
     {
-        DebugLogger::logWithCategory("ERROR", "Chamber not initialized before processBlock call");
+        RIPPLE_LOG(Chamber, Error, "Chamber not initialized before process call");
+        clearOutputs();
         return;
     }
-    if (!rayTracer->isCacheValid())
+    // Rewrites in progress don't matter here: the filters copy coefficients
+    // through a seqlock and keep their last consistent set
+    if (!rayTracer->hasPublishedResponses())
     {
-        DebugLogger::logWithCategory("ERROR", "Ray cache not valid before processBlock call");
+        RIPPLE_LOG(Chamber, Error, "No responses published before process call");
+        clearOutputs();
         return;
     }
-    inputBuffer.addSamples(input, numSamples);
-    
-    // if (bypassProcessing)
-    // {
-    //     // If bypass is enabled, just copy the input to the output
-    //     for (int i = 0; i < 3; ++i) {
-    //         if (micBuffers[i].size() < static_cast<size_t>(numSamples)) {
-    //             micBuffers[i].resize(numSamples, 0.0f);
-    //         }
-    //         std::copy(input, input + numSamples, micBuffers[i].begin());
-    //     }
-    //     return;
-    // }
-    
-    // Resize microphone buffers if needed
-    for (int i = 0; i < 3; ++i) {
-        if (micBuffers[i].size() < static_cast<size_t>(numSamples)) {
-            micBuffers[i].resize(numSamples, 0.0f);
-        }
-        std::fill(micBuffers[i].begin(), micBuffers[i].end(), 0.0f);
+    
+    const float* speaker = getSpeakerSignal(input, numSamples);
+    if (speaker == nullptr)
+    {
+        clearOutputs();
+        return;
+    }
+    
+    // One speaker plays the downmix; several play an input channel each. The
+    // count is the tracer's, whose responses the filters are about to use.
+    const int numChannels = static_cast<int>(input.getNumChannels());
+    const int numSpeakers = juce::jlimit(1, MAX_SPEAKERS, rayTracer->getNumSpeakers());
+    
+    std::array<const float*, MAX_SPEAKERS> speakerFeeds {};
+    for (int i = 0; i < numSpeakers; ++i)
+        speakerFeeds[i] = numSpeakers == 1 ? speaker : input.getChannelPointer(static_cast<size_t>(i % numChannels));
+    
+    // A speaker that has just been added starts from silence
+    for (auto& lane : micLanes)
+    {
+        for (int i = numFilteredSpeakers; i < numSpeakers; ++i)
+            lane.filters[i].resetFilterState();
     }
+    numFilteredSpeakers = numSpeakers;
+    
+    // Start or stop microphones (pre-rolling from the input history, so before this block is added)
+    updateRunningMicrophones(numSamples);
     
-    // Update current block size
-    currentBlockSize = numSamples;
+    inputBuffer.addSamples(speaker, numSamples);
+    inputSummary.process(speaker, numSamples);
+    
+    // Once the input has been silent for longer than the tail and the outputs
+    // have died away there is nothing left to compute until signal returns
+    bool inputSilent = true;
+    for (int i = 0; i < numSpeakers; ++i)
+        inputSilent = inputSilent && isSilent(speakerFeeds[i], numSamples);
 
-    processAudioForMicrophonesUsingBiquad(input, numSamples);
+    silentInputSamples = inputSilent ? juce::jmin(silentInputSamples + numSamples, std::numeric_limits<int>::max() / 2) : 0;
+    
+    const auto tailSamples = static_cast<int>(getTailLengthSeconds() * sampleRate);
+    
+    if (inputSilent && outputSilent && silentInputSamples > tailSamples)
+    {
+        if (!idle)
+        {
+            // Whatever is left in the filters is below the silence threshold
+            for (auto& lane : micLanes)
+            {
+                for (auto& filters : lane.filters)
+                    filters.resetFilterState();
+            }
+            idle = true;
+            RIPPLE_LOG(Chamber, Debug, "Input silent and tail complete; chamber idle");
+        }
+        
+        clearOutputs();
+    }
+    else
+    {
+        idle = false;
+        processAudioForMicrophonesUsingBiquad(speakerFeeds.data(), numSpeakers, outputs.data(), numSamples);
+    }
 
-    for (int i = 0; i < 3; ++i)
+    outputSilent = true;
+    for (int i = 0; i < NUM_MICROPHONES; ++i)
     {
-        outputBuffers[i].addSamples(micBuffers[i].data(), numSamples);
+        outputSilent = outputSilent && isSilent(outputs[i], numSamples);
+        
+        outputBuffers[i].addSamples(outputs[i], numSamples);
+        outputSummaries[i].process(outputs[i], numSamples);
     }
-    // Process audio for each microphone in one pass
-    // processAudioForMicrophones(input, numSamples);
 }
 
-void Chamber::processAudioForMicrophonesUsingBiquad(const float* input, int numSamples)
+bool Chamber::isSilent(const float* samples, int numSamples)
 {
-    DebugLogger::logWithCategory("CHAMBER", "Processing audio for microphones using biquad");
+    const auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+    return juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd())) < SILENCE_THRESHOLD;
+}
 
-    std::array<MicFrequencyBands, 3>& micFrequencyResponses = rayTracer->getMicFrequencyResponses();
-    // DebugLogger::logWithCategory("CHAMBER", "using these frequencies: " + micFrequencyResponses[1].toString());
+const float* Chamber::getSpeakerSignal(const juce::dsp::AudioBlock<const float>& input, int numSamples)
+{
+    const int numChannels = static_cast<int>(input.getNumChannels());
+    
+    if (numChannels == 0)
+        return nullptr;
+    
+    // A mono input drives the speaker directly
+    if (numChannels == 1)
+        return input.getChannelPointer(0);
+    
+    // Buffers are sized in prepare(); never resize on the audio thread
+    if (speakerBuffer.size() < static_cast<size_t>(numSamples))
+    {
+        jassertfalse;
+        RIPPLE_LOG(Chamber, Error, "process given {} samples, prepared for {}", numSamples, speakerBuffer.size());
+        return nullptr;
+    }
+    
+    const float channelGain = 1.0f / static_cast<float>(numChannels);
+    juce::FloatVectorOperations::copyWithMultiply(speakerBuffer.data(), input.getChannelPointer(0), channelGain, numSamples);
+    
+    for (int channel = 1; channel < numChannels; ++channel)
+    {
+        juce::FloatVectorOperations::addWithMultiply(speakerBuffer.data(), input.getChannelPointer(static_cast<size_t>(channel)), channelGain, numSamples);
+    }
+    
+    return speakerBuffer.data();
+}
 
+void Chamber::processAudioForMicrophonesUsingBiquad(const float* const* speakerFeeds, int numSpeakers, float* const* outputs, int numSamples)
+{
+    RIPPLE_LOG(Chamber, Trace, "Processing audio for microphones using biquad");
 
-    // Copy input to buffer with overlap
-    for (int sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx) {
-        for (int micIdx = 0; micIdx < 3; ++micIdx)
+    int numRunning = 0;
+    for (int micIdx = 0; micIdx < NUM_MICROPHONES; ++micIdx)
+    {
+        auto& lane = micLanes[micIdx];
+        std::copy(speakerFeeds, speakerFeeds + numSpeakers, lane.inputs.begin());
+        lane.numSpeakers = numSpeakers;
+        lane.output = outputs[micIdx];
+        lane.numSamples = numSamples;
+        lane.running = micRunning[micIdx];
+        
+        if (lane.running)
         {
-            double refInput = input[sampleIdx];
-            double output = input[sampleIdx];
-
-            for (int bandIdx = 0; bandIdx < micFrequencyResponses[micIdx].bands.size(); ++bandIdx)
-            {
-                double filterOutput = micFrequencyResponses[micIdx].bands[bandIdx].processSample(output);
-
-                // Add this band's contribution to the output
-                output += (filterOutput - input[sampleIdx]);// * micFrequencyResponses[micIdx].bands[bandIdx].gain;
-            }
-
-            // if (output != 0)
-            // {
-            //     int* ptr = nullptr;
-            //     *ptr = 10;
-            // }
-
-            micBuffers[micIdx][sampleIdx] = static_cast<float>(output);
+            syncFilterCoefficients(micIdx, numSpeakers);
+            ++numRunning;
         }
     }
-    DebugLogger::logWithCategory("CHAMBER", "Audio processing for microphones using biquad completed, Mic 2 Buffer: " + std::to_string(micBuffers[2][0]));
+    
+    // Little filtering or a single microphone is not worth handing out
+    const int work = numRunning * numSpeakers * MicFrequencyBands::NUM_FREQUENCY_BANDS * numSamples;
+    if (fanOut != nullptr && numRunning > 1 && work >= MIN_PARALLEL_WORK)
+    {
+        (*fanOut)->run(processLane, this, NUM_MICROPHONES);
+    }
+    else
+    {
+        for (int micIdx = 0; micIdx < NUM_MICROPHONES; ++micIdx)
+            processLane(this, micIdx);
+    }
+    RIPPLE_LOG(Chamber, Trace, "Audio processing for microphones using biquad completed, Mic 2 Buffer: {}", outputs[2][0]);
 }
 
-void Chamber::processAudioForMicrophones(const float* input, int numSamples)
+void Chamber::processLane(void* chamber, int mic)
 {
-    DebugLogger::logWithCategory("CHAMBER", "Processing audio for microphones");
+    auto& lane = static_cast<Chamber*>(chamber)->micLanes[static_cast<size_t>(mic)];
     
-    // Copy input to buffer with overlap
-    for (int i = 0; i < numSamples; ++i) {
-        fftInputBuffer[fftBufferPos] = input[i];
-        fftBufferPos = (fftBufferPos + 1) % FFT_SIZE;
+    // Stopped microphones cost nothing beyond clearing their output
+    if (!lane.running)
+    {
+        juce::FloatVectorOperations::clear(lane.output, lane.numSamples);
+        return;
     }
     
-    // Increment the sample counter
-    samplesSinceLastFFT += numSamples;
+    // The mic hears the sum of what reaches it from every speaker
+    filterMicrophone(lane.filters[0], lane.inputs[0], lane.output, lane.numSamples);
     
-    // Only process FFT if we've accumulated enough samples since the last processing
-    // This ensures we have enough data for proper frequency domain conversion
-    bool shouldProcessFFT = samplesSinceLastFFT >= minSamplesForFFT;
-    std::array<MicFrequencyBands, 3> micFrequencyResponses = rayTracer->getMicFrequencyResponses();
+    for (int speaker = 1; speaker < lane.numSpeakers; ++speaker)
+    {
+        filterMicrophone(lane.filters[speaker], lane.inputs[speaker], lane.speakerOutput.data(), lane.numSamples);
+        juce::FloatVectorOperations::add(lane.output, lane.speakerOutput.data(), lane.numSamples);
+    }
+}
+
+void Chamber::syncFilterCoefficients(int mic, int numSpeakers)
+{
+    // A set the message thread is rewriting right now is picked up next block
+    for (int speaker = 0; speaker < numSpeakers; ++speaker)
+        rayTracer->copyFilterCoefficients(speaker, mic, micLanes[mic].filters[speaker]);
+}
+
+void Chamber::filterMicrophone(MicFrequencyBands& response, const float* input, float* output, int numSamples)
+{
+    // output may alias input
+    for (int sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx)
+    {
+        const double refInput = input[sampleIdx];
+        double sample = refInput;
+
+        for (auto& band : response.bands)
+        {
+            double filterOutput = band.processSample(sample);
+
+            // Add this band's contribution to the output
+            sample += (filterOutput - refInput);
+        }
+
+        output[sampleIdx] = static_cast<float>(sample);
+    }
+}
+
+void Chamber::updateRunningMicrophones(int numSamples)
+{
+    const auto activeMask = activeMicrophones.load(std::memory_order_acquire);
+    const auto holdSamples = static_cast<int>(DEACTIVATION_HOLD_SECONDS * sampleRate);
     
-    if (shouldProcessFFT) {
-        DebugLogger::logWithCategory("CHAMBER", "Processing FFT after " + 
-                                    std::to_string(samplesSinceLastFFT) + " samples");
-        
-        // Reset the counter
-        samplesSinceLastFFT = 0;
+    for (int mic = 0; mic < NUM_MICROPHONES; ++mic)
+    {
+        const bool active = (activeMask & (1u << mic)) != 0;
         
-        // Process each microphone
-        for (int mic = 0; mic < 3; ++mic) {
-            // Prepare FFT input buffer with windowing
-            for (int i = 0; i < FFT_SIZE; ++i) {
-                int bufferIndex = (fftBufferPos - numSamples + i + FFT_SIZE) % FFT_SIZE;
-                fftWorkspace[i] = std::complex<float>(fftInputBuffer[bufferIndex] * windowFunction[i], 0.0f);
-            }
-            
-            // Perform forward FFT
-            fftForward->perform(fftWorkspace.data(), fftWorkspace.data(), false);
-            
-            // Apply frequency-specific attenuation while preserving phase
-            for (int i = 0; i < FFT_SIZE / 2; ++i) {
-                // Map FFT bin to frequency band
-                float frequency = i * (static_cast<float>(sampleRate) / FFT_SIZE);
-
-                // Get attenuation for this frequency band
-                float attenuation = micFrequencyResponses[mic].getBandForFrequency(frequency).value;
-                
-                // Extract magnitude and phase
-                float magnitude = std::abs(fftWorkspace[i]);
-                float phase = std::arg(fftWorkspace[i]);
-                
-                // Calculate phase difference from previous block for phase continuity
-                float phaseDelta = phase - previousPhase[mic][i];
-                
-                // Unwrap phase to avoid discontinuities
-                while (phaseDelta > M_PI) phaseDelta -= 2.0f * M_PI;
-                while (phaseDelta < -M_PI) phaseDelta += 2.0f * M_PI;
-                
-                // Update phase with smooth transition
-                phase = previousPhase[mic][i] + phaseDelta;
-                
-                // Store current phase for next block
-                previousPhase[mic][i] = phase;
-                
-                // Apply attenuation to magnitude only
-                magnitude *= attenuation;
-                
-                // Convert back to complex using preserved phase
-                fftWorkspace[i] = std::polar(magnitude, phase);
-                
-                // Handle the symmetrical part (except DC and Nyquist)
-                if (i > 0 && i < FFT_SIZE / 2) {
-                    // For the symmetrical part, we need conjugate symmetry
-                    float symmetricalPhase = -phase; // Conjugate phase
-                    
-                    // Store phase for symmetrical component
-                    previousPhase[mic][FFT_SIZE - i] = symmetricalPhase;
-                    
-                    // Apply attenuation and set with conjugate phase
-                    fftWorkspace[FFT_SIZE - i] = std::polar(magnitude, symmetricalPhase);
-                }
-            }
-            
-            // Perform inverse FFT to get time-domain signal
-            fftInverse->perform(fftWorkspace.data(), fftWorkspace.data(), true);
-            
-            // Extract real part and apply window function to reduce artifacts
-            // Only extract the last numSamples values that correspond to our input block
-            for (int i = 0; i < numSamples; ++i) {
-                // Calculate the correct index in the FFT output
-                int fftIndex = FFT_SIZE - numSamples + i;
-                
-                // Apply window function and scale
-                float sample = fftWorkspace[fftIndex].real() * windowFunction[fftIndex] / FFT_SIZE;
-                
-                // Apply a gentle soft-clipping to prevent harsh digital distortion
-                sample = std::tanh(sample * 0.8f);
-                
-                // Store the output in the buffer
-                micBuffers[mic][i] = sample;
+        if (active)
+        {
+            if (!micRunning[mic])
+            {
+                preRollMicrophone(mic);
+                micRunning[mic] = true;
+                RIPPLE_LOG(Chamber, Debug, "Microphone {} started", mic);
             }
+            micHoldSamples[mic] = holdSamples;
         }
-    } else {
-        // If we're not processing FFT this time, we still need to fill the output buffers
-        // We'll use the previous output values to avoid discontinuities
-
-        // For each microphone, copy the last processed samples
-        for (int mic = 0; mic < 3; ++mic) {
-            // If we have previous samples, use them
-            if (!micBuffers[mic].empty()) {
-                // Get the last sample value for smooth transition
-                float lastSample = micBuffers[mic].back();
-
-                // Fill the buffer with a smooth decay from the last sample
-                for (int i = 0; i < numSamples; ++i) {
-                    // Apply a gentle decay to avoid clicks
-                    float decayFactor = std::pow(0.99f, static_cast<float>(i));
-                    micBuffers[mic][i] = lastSample * decayFactor;
-                }
+        else if (micRunning[mic])
+        {
+            // Keep running until the routing fade-out has finished
+            micHoldSamples[mic] -= numSamples;
+            if (micHoldSamples[mic] <= 0)
+            {
+                micRunning[mic] = false;
+                RIPPLE_LOG(Chamber, Debug, "Microphone {} stopped", mic);
             }
         }
     }
-    
-    DebugLogger::logWithCategory("CHAMBER", "Audio processing for microphones completed");
 }
 
-void Chamber::getMicrophoneOutputBlock(int micIndex, float* outputBuffer, int numSamples) const
+void Chamber::preRollMicrophone(int mic)
 {
-    if (micIndex < 0 || micIndex >= 3 || !outputBuffer)
-        return;
+    // Run the filters over the most recent input so the microphone starts with
+    // the state it would have had if it had never stopped. Only the downmix is
+    // kept, so with several speakers each filter is warmed up from that.
+    syncFilterCoefficients(mic, numFilteredSpeakers);
     
-    DebugLogger::logWithCategory("CHAMBER", "Getting microphone output block for microphone " + std::to_string(micIndex));
+    CircularBuffer::Reader history(inputBuffer);
+    const int numHistory = history.getLatestSamples(preRollBuffer.data(), static_cast<int>(preRollBuffer.size()));
     
-    // Copy the pre-calculated microphone output directly from the buffer
-    // This is more efficient than calling getMicrophoneOutput for each sample
-    const int samplesToCopy = std::min(numSamples, currentBlockSize);
-    if (samplesToCopy > 0 && micBuffers[micIndex].size() >= static_cast<size_t>(samplesToCopy)) {
-        std::copy(micBuffers[micIndex].begin(), 
-                 micBuffers[micIndex].begin() + samplesToCopy, 
-                 outputBuffer);
-    } else {
-        // Zero out the buffer if we don't have valid data
-        std::fill(outputBuffer, outputBuffer + numSamples, 0.0f);
+    for (int speaker = 0; speaker < numFilteredSpeakers; ++speaker)
+    {
+        auto& filters = micLanes[mic].filters[speaker];
+        filters.resetFilterState();
+        filterMicrophone(filters, preRollBuffer.data(), preRollOutput.data(), numHistory);
     }
-    
-    DebugLogger::logWithCategory("CHAMBER", "Microphone output block retrieved");
 }
 
-juce::Point<float> Chamber::getSpeakerPosition() const
+juce::Point<float> Chamber::getSpeakerPosition(int index) const
 {
-    return juce::Point<float>(speakerX, speakerY);
+    if (index >= 0 && index < getNumSpeakers())
+        return speakers[static_cast<size_t>(index)];
+    
+    // Return a default position if index is out of range
+    return {0.5f, 0.5f};
 }
 
 juce::Point<float> Chamber::getMicrophonePosition(int index) const
@@ -387,9 +832,7 @@ juce::Point<float> Chamber::getMicrophonePosition(int index) const
 
 int Chamber::addZone(float x, float y, float width, float height, float density)
 {
-    DebugLogger::logWithCategory("CHAMBER", "Adding zone at (" + std::to_string(x) + ", " + std::to_string(y) + 
-                                 ") with width " + std::to_string(width) + ", height " + std::to_string(height) + 
-                                 ", and density " + std::to_string(density));
+    RIPPLE_LOG(Chamber, Debug, "Adding zone at ({}, {}) with width {}, height {}, and density {}", x, y, width, height, density);
     
     auto zone = std::make_unique<Zone>();
     zone->x = x;
@@ -400,10 +843,10 @@ int Chamber::addZone(float x, float y, float width, float height, float density)
     
     zones.push_back(std::move(zone));
 
-    //Recalc rays and store frequency responses
-    rayTracer->updateRayCache();
+    // Retrace when the result is next needed
+    markSceneDirty();
 
-    DebugLogger::logWithCategory("CHAMBER", "Zone added");
+    RIPPLE_LOG(Chamber, Debug, "Zone added");
     
     return zones.size() - 1;
 }
@@ -412,12 +855,12 @@ void Chamber::removeZone(int index)
 {
     if (index >= 0 && index < zones.size())
     {
-        DebugLogger::logWithCategory("CHAMBER", "Removing zone at index " + std::to_string(index));
+        RIPPLE_LOG(Chamber, Debug, "Removing zone at index {}", index);
         
         zones.erase(zones.begin() + index);
 
-        //Recalc rays and store frequency responses
-        rayTracer->updateRayCache();
+        // Retrace when the result is next needed
+        markSceneDirty();
     }
 }
 
@@ -425,13 +868,12 @@ void Chamber::setZoneDensity(int index, float density)
 {
     if (index >= 0 && index < zones.size())
     {
-        DebugLogger::logWithCategory("CHAMBER", "Setting zone density at index " + std::to_string(index) + 
-                                     " to " + std::to_string(density));
+        RIPPLE_LOG(Chamber, Debug, "Setting zone density at index {} to {}", index, density);
         
         zones[index]->density = density;
 
-        //Recalc rays and store frequency responses
-        rayTracer->updateRayCache();
+        // Re-evaluate when the result is next needed
+        markParametersDirty();
     }
 }
 
@@ -439,17 +881,15 @@ void Chamber::setZoneBounds(int index, float x, float y, float width, float heig
 {
     if (index >= 0 && index < zones.size())
     {
-        DebugLogger::logWithCategory("CHAMBER", "Setting zone bounds at index " + std::to_string(index) + 
-                                     " to (" + std::to_string(x) + ", " + std::to_string(y) + 
-                                     ") with width " + std::to_string(width) + ", height " + std::to_string(height));
+        RIPPLE_LOG(Chamber, Debug, "Setting zone bounds at index {} to ({}, {}) with width {}, height {}", index, x, y, width, height);
         
         zones[index]->x = juce::jlimit(0.0f, 1.0f, x);
         zones[index]->y = juce::jlimit(0.0f, 1.0f, y);
         zones[index]->width = juce::jlimit(0.0f, 1.0f - zones[index]->x, width);
         zones[index]->height = juce::jlimit(0.0f, 1.0f - zones[index]->y, height);
 
-        //Recalc rays and store frequency responses
-        rayTracer->updateRayCache();
+        // Retrace when the result is next needed
+        markSceneDirty();
     }
 }
 
@@ -458,6 +898,26 @@ const std::vector<std::unique_ptr<Zone>>& Chamber::getZones() const
     return zones;
 }
 
+TraceScene Chamber::getTraceScene() const
+{
+    TraceScene scene;
+    scene.speakers = speakers;
+    scene.microphones = micPositions;
+    scene.defaultDensity = defaultMediumDensity;
+    scene.wallReflectivity = wallReflectivity;
+    scene.wallDamping = wallDamping;
+    scene.activeMicrophones = requestedMicrophones.load();
+    
+    scene.zones.reserve(zones.size());
+    for (const auto& zone : zones)
+    {
+        if (zone != nullptr)
+            scene.zones.push_back(*zone);
+    }
+    
+    return scene;
+}
+
 
 bool Chamber::isInitialized() const
 {
@@ -466,11 +926,40 @@ bool Chamber::isInitialized() const
 
 void Chamber::setDefaultMediumDensity(float density)
 {
-    DebugLogger::logWithCategory("CHAMBER", "Setting default medium density to " + std::to_string(density));
+    if (density == defaultMediumDensity)
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Setting default medium density to {}", density);
     defaultMediumDensity = density;
 
-    //Recalc rays and store frequency responses
-    rayTracer->updateRayCache();
+    // Re-evaluate when the result is next needed
+    markParametersDirty();
+}
+
+void Chamber::setWallReflectivity(float reflectivity)
+{
+    reflectivity = juce::jlimit(0.0f, 1.0f, reflectivity);
+    if (reflectivity == wallReflectivity)
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Setting wall reflectivity to {}", reflectivity);
+    wallReflectivity = reflectivity;
+
+    // Re-evaluate when the result is next needed
+    markParametersDirty();
+}
+
+void Chamber::setWallDamping(float damping)
+{
+    damping = juce::jlimit(0.0f, 1.0f, damping);
+    if (damping == wallDamping)
+        return;
+    
+    RIPPLE_LOG(Chamber, Debug, "Setting wall damping to {}", damping);
+    wallDamping = damping;
+
+    // Re-evaluate when the result is next needed
+    markParametersDirty();
 }
 
 float Chamber::getDefaultMediumDensity() const
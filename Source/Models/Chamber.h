@@ -4,9 +4,12 @@
 #include <vector>
 #include <memory>
 #include <array>
+#include <atomic>
 #include "Zone.h"
 #include "RayTracer.h"
 #include "CircularBuffer.h"
+#include "../DSP/WaveformSummariser.h"
+#include "../DSP/BlockFanOut.h"
 
 /**
  * Chamber class that simulates a 2D rectangular chamber filled with multiple fluid/gas zones.
@@ -14,22 +17,120 @@
  * different mediums, with configurable speaker and microphone positions.
  */
 
-class Chamber
+class Chamber : private juce::AsyncUpdater,
+                private juce::Timer
 {
 public:
-    static constexpr int FFT_SIZE = 1024;    // Size of FFT for frequency analysis
+    static constexpr int NUM_MICROPHONES = 3;
+    static constexpr int MAX_SPEAKERS = RayTracer::MAX_SPEAKERS;
+    static constexpr float SILENCE_THRESHOLD = 1.0e-5f;  // -100 dBFS
     
     Chamber();
-    ~Chamber();
+    ~Chamber() override;
     
-    void initialize(float speakerX, float speakerY);
-    void processBlock(const float* input, int numSamples);
+    // Prepare for the current sample rate; the scene itself is left as it is
+    void initialize();
+    
+    /**
+     * Scene edits only mark the chamber dirty; the ray cache is rebuilt once,
+     * asynchronously on the message thread or when evaluate() is called.
+     * Edits made between beginEdit() and commitEdit() are never evaluated
+     * half-way through. Transactions may nest.
+     */
+    void beginEdit();
+    void commitEdit();
+    
+    /** Rebuild the ray cache now if the scene has changed (message thread; no-op inside a transaction). */
+    void evaluate();
+    bool isSceneDirty() const { return sceneDirty || parametersDirty; }
+    
+    /**
+     * While an interactive gesture (e.g. a drag) is in progress, evaluate()
+     * publishes a statistical estimate at once and refines it with increasing
+     * reflection depth on a background thread. Gestures may nest.
+     */
+    void beginGesture();
+    void endGesture();
+    
+    /**
+     * Geometry undo/redo (speaker, microphones and zones). A gesture that moves
+     * anything records one step; other edits call checkpointGeometry() first.
+     * Recently traced layouts are cached by the tracer, so stepping back and
+     * forth does not retrace. Returns false if there was nothing to restore.
+     */
+    void checkpointGeometry();
+    bool undoGeometry();
+    bool redoGeometry();
+    bool canUndoGeometry() const { return !undoHistory.empty(); }
+    bool canRedoGeometry() const { return !redoHistory.empty(); }
+    
+    /**
+     * Scene chunk of the plugin state: a compact versioned binary form of the
+     * speakers, microphones and zones, followed by the current mic responses
+     * (when up to date) so a restored session is heard before it is traced.
+     * readScene() leaves an identical scene untouched, so restoring the state
+     * that is already loaded costs no retrace. Returns false, leaving the scene
+     * as it was, if the chunk is malformed or from a newer version.
+     */
+    void writeScene(juce::OutputStream& stream) const;
+    bool readScene(juce::InputStream& stream);
+    
+    /** Incremented whenever readScene() replaces the geometry, so editors know to resync. */
+    uint32_t getSceneRestoreCount() const { return sceneRestoreCount.load(std::memory_order_relaxed); }
+    
+    /** RAII beginEdit()/commitEdit() pair. */
+    struct ScopedEdit
+    {
+        explicit ScopedEdit(Chamber& c) : chamber(c) { chamber.beginEdit(); }
+        ~ScopedEdit() { chamber.commitEdit(); }
+        Chamber& chamber;
+        JUCE_DECLARE_NON_COPYABLE(ScopedEdit)
+    };
+    
+    // Size the processing buffers; process must not be given more samples than this
+    void prepare(int maximumBlockSize);
+    
+    /**
+     * Filter the microphones on the shared fan-out helpers within each
+     * process() call instead of one after another. Even then a block is only
+     * handed out when its filtering (mics x speakers x bands x samples) is
+     * worth more than waking the helpers. Call while not processing, e.g.
+     * from prepareToPlay.
+     */
+    void setParallelProcessingEnabled(bool enabled);
+    
+    /**
+     * Process one block. With one speaker the input channels are mixed down to
+     * its signal (a mono input is used in place); with several, speaker i plays
+     * input channel i, wrapping round when there are fewer channels than
+     * speakers. Each microphone's output, the sum of what it picks up from
+     * every speaker, is written straight into the matching channel of micOutputs.
+     * @param input Host input channels, read only
+     * @param micOutputs At least NUM_MICROPHONES channels; may not alias the input
+     */
+    void process(const juce::dsp::AudioBlock<const float>& input, const juce::dsp::AudioBlock<float>& micOutputs);
     void setMicrophonePosition(int index, float x, float y);
-    float getMicrophoneOutput(int index) const;
-    void getMicrophoneOutputBlock(int micIndex, float* outputBuffer, int numSamples) const;
+    
+    /**
+     * Precompute mic responses over a grid of positions on every retrace, so
+     * that setMicrophonePosition() is an interpolated lookup instead of a retrace.
+     */
+    void setTransferFieldEnabled(bool enabled);
+    
+    /**
+     * Include or exclude a microphone from evaluation. Inactive microphones are
+     * neither evaluated by the tracer nor filtered, and output silence; on
+     * activation the response is brought up to date before the audio thread
+     * starts the microphone, pre-rolling its filters from recent input.
+     * Safe to call from any thread (e.g. parameter automation): off the
+     * message thread it only records the request, and the microphone is
+     * brought up to date and started from the message thread.
+     */
+    void setMicrophoneActive(int index, bool active);
+    bool isMicrophoneActive(int index) const;
     [[nodiscard]] const double getSampleRate() const { return sampleRate; }
     
-    // Parameter setters
+    // Parameter setters. Wall values (0-1) and densities re-evaluate the traced paths without retracing
     void setMediumDensity(float density);
     void setWallReflectivity(float reflectivity);
     void setWallDamping(float damping);
@@ -41,102 +142,195 @@ public:
     void setZoneDensity(int zoneId, float density);
     void setZoneBounds(int zoneId, float x1, float y1, float x2, float y2);
     [[nodiscard]] const std::vector<std::unique_ptr<Zone>>& getZones() const;
+    /** Copy of everything the tracer reads, safe to hand to another thread. */
+    [[nodiscard]] TraceScene getTraceScene() const;
     
     // Microphone management
-    [[nodiscard]] const std::array<juce::Point<float>, 3>& getMicrophonePositions() const { return micPositions; }
+    [[nodiscard]] const std::array<juce::Point<float>, NUM_MICROPHONES>& getMicrophonePositions() const { return micPositions; }
     
-    // Speaker position
-    [[nodiscard]] float getSpeakerX() const { return speakerX; }
-    [[nodiscard]] float getSpeakerY() const { return speakerY; }
-    void setSpeakerPosition(float x, float y);
-    juce::Point<float> getSpeakerPosition() const;
+    /**
+     * Speakers: at least one and up to MAX_SPEAKERS, all traced together in
+     * one pass. The overloads without an index refer to the first speaker.
+     */
+    [[nodiscard]] int getNumSpeakers() const { return static_cast<int>(speakers.size()); }
+    int addSpeaker(float x, float y);           // Index of the new speaker, or -1 if there are already MAX_SPEAKERS
+    void removeSpeaker(int index);              // The last remaining speaker stays
+    void setSpeakerPosition(int index, float x, float y);
+    juce::Point<float> getSpeakerPosition(int index) const;
+    
+    [[nodiscard]] float getSpeakerX() const { return speakers.front().x; }
+    [[nodiscard]] float getSpeakerY() const { return speakers.front().y; }
+    void setSpeakerPosition(float x, float y) { setSpeakerPosition(0, x, y); }
+    juce::Point<float> getSpeakerPosition() const { return getSpeakerPosition(0); }
 
-    const std::vector<Ray>& getCachedRays() const { return rayTracer->getCachedRays(); }
+    // Ray and response getters evaluate pending edits first
+    const std::vector<Ray>& getCachedRays() { evaluate(); return rayTracer->getCachedRays(); }
     bool isInitialized() const;
     void setDefaultMediumDensity(float density);
     float getDefaultMediumDensity() const;
     juce::Point<float> getMicrophonePosition(int index) const;
     
-    // Getter for microphone frequency responses (for visualization)
-    const std::array<MicFrequencyBands, 3>& getMicFrequencyResponses() const { return rayTracer->getMicFrequencyResponses(); }
+    // Getter for microphone frequency responses to the first speaker (for visualization)
+    const std::array<MicFrequencyBands, NUM_MICROPHONES>& getMicFrequencyResponses() { evaluate(); return rayTracer->getMicFrequencyResponses(); }
+    
+    /**
+     * Copy the coefficients the audio thread should filter a mic's response to
+     * one speaker with now; false (filters untouched) if the message thread is
+     * rewriting them. Never evaluates or blocks (audio thread).
+     */
+    bool copyMicCoefficients(int mic, int speaker, MicFrequencyBands& filters) const noexcept { return rayTracer->copyFilterCoefficients(speaker, mic, filters); }
     
-    // Getter for microphone output buffer (for visualization)
-    const std::array<std::vector<float>, 3>& getMicBuffers() const { return micBuffers; }
-    CircularBuffer& getInputBuffer() { return inputBuffer; }
-    CircularBuffer& getOutputBuffer(int index) { return outputBuffers[index]; }
+    // Speakers the published responses cover, i.e. the ones process() filters (any thread)
+    int getNumFilteredSpeakers() const noexcept { return rayTracer->getNumSpeakers(); }
+
+    // Sample streams written by process; consumers read them through their own CircularBuffer::Reader
+    const CircularBuffer& getInputBuffer() const { return inputBuffer; }
+    const CircularBuffer& getOutputBuffer(int index) const { return outputBuffers[index]; }
 
-    void setBypassProcessing(bool bypass);
+    // Decimated waveform columns for the visualizers (single reader each)
+    WaveformSummariser& getInputSummary() { return inputSummary; }
+    WaveformSummariser& getOutputSummary(int index) { return outputSummaries[index]; }
 
+    // Decay time of the current response (traced RT60 or filter ring-out, whichever is longer)
+    double getTailLengthSeconds() const { return rayTracer->getTailLengthSeconds(); }
+
+    /**
+     * The rate process() runs at. Only the filter coefficients depend on it,
+     * so they are recomputed from the current responses without a retrace.
+     * Call while not processing, before initialize() (e.g. from prepareToPlay).
+     */
     void setSampleRate(double sampleRate);
 
 private:
+    /** Snapshot of the positions restored by undo/redo. */
+    struct Geometry
+    {
+        std::vector<juce::Point<float>> speakers;
+        std::array<juce::Point<float>, NUM_MICROPHONES> microphones;
+        std::vector<Zone> zones;
+        
+        bool operator==(const Geometry& other) const
+        {
+            return speakers == other.speakers && microphones == other.microphones && zones == other.zones;
+        }
+        bool operator!=(const Geometry& other) const { return !(*this == other); }
+    };
+    
+    Geometry captureGeometry() const;
+    void restoreGeometry(const Geometry& geometry);
+    void pushUndoStep(Geometry geometry);
+    
+    void markSceneDirty();
+    void markParametersDirty();
+    void scheduleEvaluation();
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+    void startRequestedMicrophones();
 
-    void processAudioForMicrophones(const float* input, int numSamples);
-    void processAudioForMicrophonesUsingBiquad(const float* input, int numSamples);
+    static bool isSilent(const float* samples, int numSamples);
+    static void filterMicrophone(MicFrequencyBands& response, const float* input, float* output, int numSamples);
+    void updateRunningMicrophones(int numSamples);
+    void preRollMicrophone(int mic);
+    const float* getSpeakerSignal(const juce::dsp::AudioBlock<const float>& input, int numSamples);
+    void processAudioForMicrophonesUsingBiquad(const float* const* speakerFeeds, int numSpeakers, float* const* outputs, int numSamples);
+    void syncFilterCoefficients(int mic, int numSpeakers);
+    static void processLane(void* chamber, int mic);
 
     //In/Out buffers
     CircularBuffer inputBuffer;
-    std::array<CircularBuffer, 3> outputBuffers;
+    std::array<CircularBuffer, NUM_MICROPHONES> outputBuffers;
+    WaveformSummariser inputSummary;
+    std::array<WaveformSummariser, NUM_MICROPHONES> outputSummaries;
     
-    // Ray tracing
-    float defaultMediumDensity;
-    std::unique_ptr<RayTracer> rayTracer;
-
-    // FFT data for each microphone
-    std::array<std::vector<std::complex<float>>, 3> micFFTData;
+    // Mono downmix of a multichannel input, sized in prepare(); drives a single
+    // speaker, and the input history, meters and silence detection for several
+    std::vector<float> speakerBuffer;
+    
+    // Demand-driven microphones: the requested set (any thread), the set whose
+    // responses are up to date for the audio thread (set on the message thread
+    // only), and what the audio thread is running
+    static constexpr int PRE_ROLL_SAMPLES = 4096;
+    static constexpr double DEACTIVATION_HOLD_SECONDS = 0.05;   // outlasts the routing fade-out
+    std::atomic<uint32_t> requestedMicrophones { (1u << NUM_MICROPHONES) - 1 };
+    std::atomic<uint32_t> activeMicrophones { (1u << NUM_MICROPHONES) - 1 };
+    std::array<bool, NUM_MICROPHONES> micRunning { true, true, true };
+    std::array<int, NUM_MICROPHONES> micHoldSamples {};
+    std::vector<float> preRollBuffer;   // input history, read once per pre-roll
+    std::vector<float> preRollOutput;   // discarded filter output
     
-    // Previous phase information for phase continuity
-    std::array<std::vector<float>, 3> previousPhase;
+    /**
+     * The audio thread's filters for one microphone, one per speaker, with the
+     * block it is working on. Coefficients are copied from the tracer's
+     * responses every block; the state lives here, on cache lines of its own,
+     * so lanes filtered on different threads never share one.
+     */
+    struct alignas(64) MicLane
+    {
+        std::array<MicFrequencyBands, MAX_SPEAKERS> filters;
+        std::array<const float*, MAX_SPEAKERS> inputs {};
+        int numSpeakers = 1;
+        float* output = nullptr;
+        int numSamples = 0;
+        bool running = false;
+        std::vector<float> speakerOutput;   // one speaker's part before it is summed, sized in prepare()
+    };
+    std::array<MicLane, NUM_MICROPHONES> micLanes;
+    int numFilteredSpeakers = 1;        // Speakers the lanes' filter state belongs to (audio thread)
     
-    // Microphone output buffers
-    std::array<std::vector<float>, 3> micBuffers;
+    // Fan-out of the lanes; null unless parallel processing is enabled.
+    // Below this many band-samples of filtering per block (about one
+    // quantum of three mics hearing four speakers) a wake-up costs more
+    // than it saves.
+    static constexpr int MIN_PARALLEL_WORK = 2048;
+    std::unique_ptr<juce::SharedResourcePointer<BlockFanOut>> fanOut;
     
-    // Current block size and sample index
-    int currentBlockSize;
-    int currentSampleIndex;
+    // Scene evaluation state (message thread; edit depth is also read by
+    // parameter setters called from automation on the audio thread)
+    std::atomic<int> editDepth { 0 };
+    int interactiveGestures = 0;
     
-    // FFT processing control
-    int samplesSinceLastFFT;
-    int minSamplesForFFT;
+    // Evaluations asked for off the message thread, where posting a message
+    // may lock or allocate; the timer picks them up
+    static constexpr int EVALUATION_POLL_MS = 20;
+    std::atomic<bool> evaluationRequested { false };
     
-    // Debug control
-    bool bypassProcessing; // When true, input is copied directly to output without processing
+    // Geometry history (message thread)
+    static constexpr size_t MAX_UNDO_STEPS = 64;
+    std::vector<Geometry> undoHistory;
+    std::vector<Geometry> redoHistory;
+    Geometry gestureStartGeometry;
     
-    // FFT objects
-    std::unique_ptr<juce::dsp::FFT> fftForward;
-    std::unique_ptr<juce::dsp::FFT> fftInverse;
+    // Saved scene chunks (version 1 had exactly one speaker)
+    static constexpr int SCENE_FORMAT_VERSION = 2;
+    static constexpr int MAX_SAVED_ZONES = 1024;
+    std::atomic<uint32_t> sceneRestoreCount { 0 };
+    std::atomic<bool> sceneDirty { false };   // may be set by parameter changes on the audio thread
+    std::atomic<bool> parametersDirty { false };   // only wall or medium values changed
     
-    // Input buffer for FFT processing
-    std::vector<float> fftInputBuffer;
-    std::vector<std::complex<float>> fftWorkspace;
+    // Ray tracing; set from parameter changes on any thread
+    std::atomic<float> defaultMediumDensity;
+    std::unique_ptr<RayTracer> rayTracer;
+
+    // Silence detection: samples of silent input so far, and whether the last output block was silent
+    int silentInputSamples = 0;
+    bool outputSilent = true;
+    bool idle = false;
     
     bool initialized;
     double sampleRate;
-    float speakerX;
-    float speakerY;
+    std::vector<juce::Point<float>> speakers;
     
-    // Chamber parameters
+    // Chamber parameters; wall values are set from parameter changes on any thread
     float mediumDensity;
-    float wallReflectivity;
-    float wallDamping;
-    
-    // FFT processing
-    int fftSize;
-    std::vector<float> fftData;
-    std::vector<float> fftOutput;
-    std::vector<float> windowFunction;
-    int fftBufferPos;
-
-    // Audio processing
-    std::vector<float> fftTimeBuffer;       // Time domain buffer
-    std::vector<float> fftFrequencyBuffer;  // Frequency domain buffer
+    std::atomic<float> wallReflectivity;
+    std::atomic<float> wallDamping;
     
     // Zones
     std::vector<std::unique_ptr<Zone>> zones;
     int nextZoneId;
     
-    // Microphone positions (up to 3)
-    std::array<juce::Point<float>, 3> micPositions;
+    // Microphone positions
+    std::array<juce::Point<float>, NUM_MICROPHONES> micPositions;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Chamber)
 };
@@ -1,54 +1,177 @@
 #pragma once
-#include <array>
-#include "../DebugLogger.h"
 
-struct CircularBuffer
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+
+/**
+ * Lock-free single-writer ring of audio samples with any number of independent readers.
+ *
+ * The audio thread writes with addSamples(); every consumer (visualizer,
+ * analyzer, recorder...) owns a CircularBuffer::Reader with its own read
+ * position, so each sees the complete stream. The writer never waits for
+ * readers: a reader that falls more than one capacity behind loses the
+ * oldest samples instead of stalling the audio thread.
+ *
+ * Positions are 64-bit running sample counts published with acquire/release
+ * ordering; the capacity is a power of two so wrapping is a mask, and reads
+ * and writes are at most two memcpy segments.
+ */
+class CircularBuffer
 {
-    std::array<float, 48000> buffer;
-    int writeIndex = 0;
-    int readIndex = 0;
-    int size = 48000;
+public:
+    static constexpr int DEFAULT_CAPACITY = 1 << 16;
 
-    CircularBuffer()
+    explicit CircularBuffer(int capacityPowerOfTwo = DEFAULT_CAPACITY)
+        : capacity(static_cast<uint64_t>(capacityPowerOfTwo)),
+          mask(static_cast<uint64_t>(capacityPowerOfTwo) - 1),
+          buffer(new float[static_cast<size_t>(capacityPowerOfTwo)]())
     {
-        buffer.fill(0.0f);
+        jassert(capacityPowerOfTwo > 0 && (capacityPowerOfTwo & (capacityPowerOfTwo - 1)) == 0);
     }
 
-    void addSamples(const float* sample, const int numSamples)
+    /** Append samples. Must only be called from the single writer thread. */
+    void addSamples(const float* samples, int numSamples) noexcept
     {
-        if (numSamples > size) {
-          DebugLogger::logWithCategory("ERROR", "CircularBuffer::addSamples: numSamples > size");
+        if (numSamples <= 0)
+            return;
+
+        const auto start = writePosition.load(std::memory_order_relaxed);
+        const auto end = start + static_cast<uint64_t>(numSamples);
+
+        // Only the newest 'capacity' samples of an oversized block can be kept
+        const auto toWrite = std::min<uint64_t>(static_cast<uint64_t>(numSamples), capacity);
+        samples += static_cast<uint64_t>(numSamples) - toWrite;
+
+        // Announce which samples are about to be overwritten before touching them,
+        // so readers copying concurrently can detect torn data
+        reservePosition.store(end, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        copyIn(end - toWrite, samples, toWrite);
+
+        writePosition.store(end, std::memory_order_release);
+    }
+
+    /** Running count of samples written so far. */
+    uint64_t getWritePosition() const noexcept { return writePosition.load(std::memory_order_acquire); }
+
+    int getCapacity() const noexcept { return static_cast<int>(capacity); }
+
+    /**
+     * An independent read cursor into a CircularBuffer.
+     * Each reader must only be used from one thread at a time.
+     */
+    class Reader
+    {
+    public:
+        /** Create a reader that starts at the buffer's current write position. */
+        explicit Reader(const CircularBuffer& source) noexcept
+            : buffer(&source),
+              readPosition(source.getWritePosition())
+        {
         }
 
-        for (int i = 0; i < numSamples; ++i)
+        /** Number of unread samples (capped at the buffer capacity). */
+        int getNumReady() const noexcept
         {
-            int bufferIndex = (writeIndex + i) % size;
-            buffer[bufferIndex] = sample[i];
+            return static_cast<int>(std::min(buffer->getWritePosition() - readPosition, buffer->capacity));
         }
-        writeIndex = (writeIndex + numSamples) % size;
-    }
 
-    int getSamples(float* outputBuffer, const int requestedSamples)
-    {
-        int samplesToRead = 0;
-        int projectedWriteIndex = writeIndex;
+        /**
+         * Read up to requestedSamples of the oldest unread samples.
+         * @return The number of samples copied to outputBuffer
+         */
+        int getSamples(float* outputBuffer, int requestedSamples) noexcept
+        {
+            const auto written = buffer->getWritePosition();
+
+            // If we've been lapped, skip ahead to the oldest sample still held
+            if (written - readPosition > buffer->capacity)
+                readPosition = written - buffer->capacity;
+
+            auto numToRead = std::min<uint64_t>(written - readPosition, static_cast<uint64_t>(std::max(0, requestedSamples)));
+            numToRead = validateRead(outputBuffer, readPosition, numToRead);
 
-        if (readIndex > writeIndex)
-            projectedWriteIndex = writeIndex + size;
+            return static_cast<int>(numToRead);
+        }
+
+        /**
+         * Copy the most recent numSamples samples without consuming anything
+         * older than them; the read position moves to the end of the stream.
+         * @return The number of samples copied to outputBuffer
+         */
+        int getLatestSamples(float* outputBuffer, int numSamples) noexcept
+        {
+            const auto written = buffer->getWritePosition();
+            const auto wanted = std::min<uint64_t>(static_cast<uint64_t>(std::max(0, numSamples)),
+                                                   std::min(written, buffer->capacity));
+
+            readPosition = written - wanted;
+            return static_cast<int>(validateRead(outputBuffer, readPosition, wanted));
+        }
 
-        if (readIndex + requestedSamples > projectedWriteIndex)
-            samplesToRead = projectedWriteIndex - readIndex;
-        else
-            samplesToRead = requestedSamples;
+        /** Drop everything unread. */
+        void skipToLatest() noexcept { readPosition = buffer->getWritePosition(); }
 
-        for (int i = 0; i < samplesToRead; ++i)
+    private:
+        // Copies [position, position + numSamples), then discards any prefix the
+        // writer may have overwritten during the copy. Advances readPosition past
+        // what was returned and returns the number of valid samples.
+        uint64_t validateRead(float* outputBuffer, uint64_t position, uint64_t numSamples) noexcept
         {
-            int bufferIndex = (readIndex + i) % size;
-            outputBuffer[i] = buffer[bufferIndex];
+            buffer->copyOut(position, outputBuffer, numSamples);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const auto reserved = buffer->reservePosition.load(std::memory_order_relaxed);
+            const auto oldestValid = reserved > buffer->capacity ? reserved - buffer->capacity : 0;
+
+            if (position < oldestValid)
+            {
+                const auto torn = std::min(oldestValid - position, numSamples);
+                std::memmove(outputBuffer, outputBuffer + torn, static_cast<size_t>(numSamples - torn) * sizeof(float));
+                position += torn;
+                numSamples -= torn;
+            }
+
+            readPosition = position + numSamples;
+            return numSamples;
         }
 
-        readIndex = (readIndex + samplesToRead) % size;
+        const CircularBuffer* buffer;
+        uint64_t readPosition;
+    };
 
-        return samplesToRead;
+private:
+    void copyIn(uint64_t position, const float* source, uint64_t numSamples) noexcept
+    {
+        const auto start = position & mask;
+        const auto first = std::min(numSamples, capacity - start);
+
+        std::memcpy(buffer.get() + start, source, static_cast<size_t>(first) * sizeof(float));
+        std::memcpy(buffer.get(), source + first, static_cast<size_t>(numSamples - first) * sizeof(float));
+    }
+
+    void copyOut(uint64_t position, float* destination, uint64_t numSamples) const noexcept
+    {
+        const auto start = position & mask;
+        const auto first = std::min(numSamples, capacity - start);
+
+        std::memcpy(destination, buffer.get() + start, static_cast<size_t>(first) * sizeof(float));
+        std::memcpy(destination + first, buffer.get(), static_cast<size_t>(numSamples - first) * sizeof(float));
     }
-};
\ No newline at end of file
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    const uint64_t capacity;
+    const uint64_t mask;
+    std::unique_ptr<float[]> buffer;
+
+    // Writer-owned positions, kept off the cache lines that hold the
+    // read-only members above. Read positions live in each Reader.
+    alignas(CACHE_LINE) std::atomic<uint64_t> writePosition { 0 };
+    std::atomic<uint64_t> reservePosition { 0 };
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <DebugLogger.h>
@@ -71,6 +72,16 @@ struct FrequencyBand
 
     }
 
+    // Magnitude of the slowest-decaying pole of the filter
+    double getPoleRadius() const {
+        double discriminant = biquad.a1 * biquad.a1 - 4.0 * biquad.a2;
+        if (discriminant < 0.0)
+            return std::sqrt(std::abs(biquad.a2));
+
+        double root = std::sqrt(discriminant);
+        return std::max(std::abs(-biquad.a1 + root), std::abs(-biquad.a1 - root)) / 2.0;
+    }
+
     float processSample(float sample) {
         // Apply biquad filter
         double y = biquad.b0 * sample + biquad.b1 * biquad.z1 + biquad.b2 * biquad.z2 - biquad.a1 * biquad.z1 - biquad.a2 * biquad.z2;
@@ -86,6 +97,7 @@ struct MicFrequencyBands
     static constexpr int NUM_FREQUENCY_BANDS = 3;
     static constexpr int MIN_FREQUENCY = 20;
     static constexpr int MAX_FREQUENCY = 12000;
+    using BandValues = std::array<float, NUM_FREQUENCY_BANDS>;
     std::array<FrequencyBand, NUM_FREQUENCY_BANDS> bands;
     MicFrequencyBands()
     {
@@ -111,6 +123,14 @@ struct MicFrequencyBands
             bands[i].value = value;
         }
     }
+    void resetFilterState()
+    {
+        for (int i = 0; i < NUM_FREQUENCY_BANDS; ++i)
+        {
+            bands[i].biquad.z1 = 0.0;
+            bands[i].biquad.z2 = 0.0;
+        }
+    }
     void calculateBiquadCoefficients(double sampleRate)
     {
         for (int i = 0; i < NUM_FREQUENCY_BANDS; ++i)
@@ -0,0 +1,92 @@
+#include "PathRecords.h"
+#include <cmath>
+
+void PathRecords::reserve(size_t numRays)
+{
+    parents.reserve(numRays);
+    events.reserve(numRays);
+}
+
+int PathRecords::addPrimaryRay()
+{
+    parents.push_back(-1);
+    events.push_back(WALL);
+    return static_cast<int>(parents.size() - 1);
+}
+
+int PathRecords::addChildRay(int parent, int16_t event)
+{
+    jassert(parent >= 0 && parent < static_cast<int>(parents.size()));
+
+    parents.push_back(parent);
+    events.push_back(event);
+    return static_cast<int>(parents.size() - 1);
+}
+
+void PathRecords::append(const PathRecords& other)
+{
+    jassert(wallHits.empty() && other.wallHits.empty());
+
+    const auto offset = static_cast<int32_t>(parents.size());
+    reserve(parents.size() + other.parents.size());
+
+    for (const auto parent : other.parents)
+        parents.push_back(parent < 0 ? parent : parent + offset);
+
+    events.insert(events.end(), other.events.begin(), other.events.end());
+}
+
+void PathRecords::finalise(int numZones)
+{
+    const auto numRays = parents.size();
+
+    wallHits.assign(numRays, 0.0f);
+    zoneCrossings.assign(static_cast<size_t>(juce::jmax(0, numZones)), std::vector<float>(numRays, 0.0f));
+
+    // Parents come first, so one forward pass accumulates every path
+    for (size_t ray = 0; ray < numRays; ++ray)
+    {
+        const auto parent = parents[ray];
+        if (parent < 0)
+            continue;
+
+        wallHits[ray] = wallHits[static_cast<size_t>(parent)];
+        for (auto& crossings : zoneCrossings)
+            crossings[ray] = crossings[static_cast<size_t>(parent)];
+
+        const auto event = events[ray];
+        if (event == WALL)
+            wallHits[ray] += 1.0f;
+        else if (event >= 0 && event < numZones)
+            zoneCrossings[static_cast<size_t>(event)][ray] += 1.0f;
+    }
+}
+
+void PathRecords::replay(const EventFactors& factors, BandGains& gains) const
+{
+    jassert(static_cast<int>(factors.zones.size()) == getNumZones());
+
+    const auto numRays = static_cast<int>(wallHits.size());
+
+    // Products of factors become sums of logs: gain = exp(hits * log(factor) + ...)
+    constexpr float minimumFactor = 1.0e-6f;
+
+    for (int band = 0; band < NUM_BANDS; ++band)
+    {
+        auto& bandGains = gains[static_cast<size_t>(band)];
+        bandGains.resize(static_cast<size_t>(numRays));
+        auto* logGains = bandGains.data();
+
+        const float logWall = std::log(juce::jmax(minimumFactor, factors.wall[static_cast<size_t>(band)]));
+        juce::FloatVectorOperations::copyWithMultiply(logGains, wallHits.data(), logWall, numRays);
+
+        for (size_t zone = 0; zone < zoneCrossings.size(); ++zone)
+        {
+            const float logZone = std::log(juce::jmax(minimumFactor, factors.zones[zone][static_cast<size_t>(band)]));
+            juce::FloatVectorOperations::addWithMultiply(logGains, zoneCrossings[zone].data(), logZone, numRays);
+        }
+
+        for (int ray = 0; ray < numRays; ++ray)
+            logGains[ray] = std::exp(logGains[ray]);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "MicFrequencyBands.h"
+
+/**
+ * Compact structure-of-arrays record of how every traced ray came to exist.
+ *
+ * A ray's per-band gain is its parent's gain times the factor of the event
+ * that created it: a wall reflection or a zone boundary crossing. Path
+ * geometry and ray intensities never depend on the wall or medium
+ * parameters, so replaying the records with new factors reproduces the band
+ * gains of a retrace without tracing anything.
+ *
+ * Rays are recorded in trace order (parents before children). finalise()
+ * turns the parent links into per-ray event counts, so replay() is a few
+ * multiply-adds over contiguous arrays per band.
+ */
+class PathRecords
+{
+public:
+    static constexpr int NUM_BANDS = MicFrequencyBands::NUM_FREQUENCY_BANDS;
+    static constexpr int16_t WALL = -1;     // Event of a wall reflection; zone crossings store the zone index
+
+    using BandValues = MicFrequencyBands::BandValues;
+    using BandGains = std::array<std::vector<float>, NUM_BANDS>;
+
+    /** Per-band factor applied by each kind of event. */
+    struct EventFactors
+    {
+        BandValues wall {};
+        std::vector<BandValues> zones;
+    };
+
+    PathRecords() = default;
+
+    void reserve(size_t numRays);
+
+    /** Record a ray leaving the speaker. @return its index */
+    int addPrimaryRay();
+
+    /** Record a ray created by an event on its parent's path. @return its index */
+    int addChildRay(int parent, int16_t event);
+
+    /** Record every ray of another, unfinalised set after this one's, e.g. another speaker's. */
+    void append(const PathRecords& other);
+
+    /** Derive the event counts; call once after the last ray is recorded. */
+    void finalise(int numZones);
+
+    size_t getNumRays() const noexcept { return parents.size(); }
+    int getNumZones() const noexcept { return static_cast<int>(zoneCrossings.size()); }
+
+    // Raw records, for serialisation
+    const std::vector<int32_t>& getParents() const noexcept { return parents; }
+    const std::vector<int16_t>& getEvents() const noexcept { return events; }
+
+    /**
+     * Per-band gains of every ray for the given factors, band-major.
+     * @param gains Resized as needed; reuse it to avoid allocating
+     */
+    void replay(const EventFactors& factors, BandGains& gains) const;
+
+private:
+    std::vector<int32_t> parents;       // -1 for primary rays
+    std::vector<int16_t> events;        // WALL or a zone index; unused for primary rays
+
+    // Filled by finalise()
+    std::vector<float> wallHits;
+    std::vector<std::vector<float>> zoneCrossings;     // [zone][ray]
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PathRecords)
+};
@@ -1,7 +1,10 @@
 #include "RayTracer.h"
 #include "Chamber.h"
 #include "Zone.h"
+#include "SharedTraceCache.h"
 #include "../DebugLogger.h"
+#include <algorithm>
+#include <cstring>
 
 // Define M_PI if not already defined
 #ifndef M_PI
@@ -12,13 +15,21 @@
 RayTracer::RayTracer() :
  	initialized(false),
     raysCacheValid(false),
-	isProcessing(false)
+	isProcessing(false),
+    publishedRays(std::make_shared<const std::vector<Ray>>())
 {
 }
 
 RayTracer::~RayTracer()
 {
-    // Clean up any resources
+    // Running refinement stops at its next stage
+    ++latestGeneration;
+    refinementJobs.cancelPending();
+    refinementJobs.waitForAll();
+    transferFieldJobs.cancelPending();
+    transferFieldJobs.waitForAll();
+
+    cancelPendingUpdate();
 }
 
 void RayTracer::initialize(Chamber* parentChamber)
@@ -27,14 +38,14 @@ void RayTracer::initialize(Chamber* parentChamber)
     chamber = parentChamber;
     initialized = true;
 
-    DebugLogger::logWithCategory("TRACER", "TRACER initialization completed");
+    RIPPLE_LOG(Tracer, Debug, "TRACER initialization completed");
 }
 
 // Ray tracing methods
-Intersection RayTracer::traceRay(const Ray& ray) const
+Intersection RayTracer::traceRay(const TraceScene& scene, const Ray& ray) const
 {
-    DebugLogger::logWithCategory("RAY", "Tracing ray");
-    const std::vector<std::unique_ptr<Zone>>& zones = chamber->getZones();
+    RIPPLE_LOG(Ray, Trace, "Tracing ray");
+    const std::vector<Zone>& zones = scene.zones;
 
     Intersection result;
     result.hit = false;
@@ -124,7 +135,7 @@ Intersection RayTracer::traceRay(const Ray& ray) const
     // Check intersection with zone boundaries
     for (int i = 0; i < zones.size(); ++i)
     {
-        const auto& zone = zones[i];
+        const Zone* zone = &zones[i];
 
         // Left boundary (x = zone->x)
         if (ray.direction.x != 0)
@@ -203,14 +214,14 @@ Intersection RayTracer::traceRay(const Ray& ray) const
         }
     }
 
-    DebugLogger::logWithCategory("RAY", "Ray tracing completed");
+    RIPPLE_LOG(Ray, Trace, "Ray tracing completed");
 
     return result;
 }
 
 float RayTracer::calculateRayContribution(const Ray& ray, const juce::Point<float>& micPosition) const
 {
-    DebugLogger::logWithCategory("RAY", "Calculating ray contribution");
+    RIPPLE_LOG(Ray, Trace, "Calculating ray contribution");
 
     // Calculate vector from ray position to microphone
     juce::Point<float> rayToMic(micPosition.x - ray.origin.x, micPosition.y - ray.origin.y);
@@ -249,14 +260,14 @@ float RayTracer::calculateRayContribution(const Ray& ray, const juce::Point<floa
     // Apply bounce attenuation (rays with more bounces contribute less)
     contribution *= std::pow(0.8f, ray.bounceCount);
 
-    DebugLogger::logWithCategory("RAY", "Ray contribution calculated");
+    RIPPLE_LOG(Ray, Trace, "Ray contribution calculated");
 
     return contribution;
 }
 
-std::vector<Ray> RayTracer::generateReflectionRays(const Ray& ray, const Intersection& intersection) const
+std::vector<Ray> RayTracer::generateReflectionRays(const TraceScene& scene, const Ray& ray, const Intersection& intersection) const
 {
-    DebugLogger::logWithCategory("RAY", "Generating reflection rays");
+    RIPPLE_LOG(Ray, Trace, "Generating reflection rays");
 
     std::vector<Ray> reflectionRays;
 
@@ -280,13 +291,13 @@ std::vector<Ray> RayTracer::generateReflectionRays(const Ray& ray, const Interse
     // Increase bounce count
     reflectionRay.bounceCount = ray.bounceCount + 1;
 
-    DebugLogger::logWithCategory("RAY", "Copying Frequency Bands");
+    RIPPLE_LOG(Ray, Trace, "Copying Frequency Bands");
     // Copy frequency bands
     reflectionRay.frequencyBands = ray.frequencyBands;
-    DebugLogger::logWithCategory("RAY", "Copied Frequency Bands");
+    RIPPLE_LOG(Ray, Trace, "Copied Frequency Bands");
 
     // Update frequency bands based on the intersection
-    updateRayFrequencies(reflectionRay, intersection);
+    updateRayFrequencies(scene, reflectionRay, intersection);
 
     reflectionRays.push_back(reflectionRay);
 
@@ -327,15 +338,15 @@ std::vector<Ray> RayTracer::generateReflectionRays(const Ray& ray, const Interse
         }
     }
 
-    DebugLogger::logWithCategory("RAY", "Reflection rays generated");
+    RIPPLE_LOG(Ray, Trace, "Reflection rays generated");
 
     return reflectionRays;
 }
 
-void RayTracer::updateRayFrequencies(Ray& ray, const Intersection& intersection) const
+void RayTracer::updateRayFrequencies(const TraceScene& scene, Ray& ray, const Intersection& intersection) const
 {
-    DebugLogger::logWithCategory("RAY", "Updating ray frequencies");
-    const std::vector<std::unique_ptr<Zone>>& zones = chamber->getZones();
+    RIPPLE_LOG(Ray, Trace, "Updating ray frequencies");
+    const std::vector<Zone>& zones = scene.zones;
 
     if (!intersection.hit)
         return;
@@ -346,38 +357,17 @@ void RayTracer::updateRayFrequencies(Ray& ray, const Intersection& intersection)
         // Walls absorb high frequencies more than low frequencies
         for (int i = 0; i < ray.frequencyBands.bands.size(); ++i)
         {
-            float freq = 100.0f * std::pow(2.0f, i); // Approximate frequency for this band
-            float absorptionFactor = 0.1f + 0.05f * std::log10(freq / 100.0f); // Higher frequencies absorb more
-            ray.frequencyBands.bands[i].value *= (1.0f - absorptionFactor);
+            ray.frequencyBands.bands[i].value *= (1.0f - getWallAbsorption(scene, i));
         }
     }
     else if (intersection.zoneId >= 0 && intersection.zoneId < zones.size())
     {
         // Zone boundary crossings
-        // Only proceed if we have a valid zone
-        if (zones[intersection.zoneId])
-        {
-            float zoneDensity = zones[intersection.zoneId]->density;
-
-            // Calculate impedance ratio
-            float z1 = chamber->getDefaultMediumDensity(); // Use the default medium density from the class member
-            float z2 = zoneDensity; // Zone impedance
-
-            // Calculate transmission coefficient for each frequency band
-            for (int i = 0; i < ray.frequencyBands.bands.size(); ++i)
-            {
-                // Frequency-dependent transmission coefficient
-                // Higher frequencies are more affected by density changes
-                float freq = 100.0f * std::pow(2.0f, i); // Approximate frequency for this band
-                float freqFactor = 0.5f + 0.5f * std::log10(freq / 100.0f) / 3.0f;
-                float densityDiff = std::abs(z2 - z1) * freqFactor;
-
-                // Transmission coefficient (simplified model)
-                float T = 1.0f - densityDiff / (z1 + z2);
-                T = juce::jlimit(0.1f, 1.0f, T); // Limit to reasonable range
+        const Zone& zone = zones[intersection.zoneId];
 
-                ray.frequencyBands.bands[i].value *= T;
-            }
+        for (int i = 0; i < ray.frequencyBands.bands.size(); ++i)
+        {
+            ray.frequencyBands.bands[i].value *= getZoneTransmission(scene, zone, i);
         }
     }
 
@@ -388,29 +378,70 @@ void RayTracer::updateRayFrequencies(Ray& ray, const Intersection& intersection)
     // Apply additional attenuation for each bounce
     ray.intensity *= 0.8f;
 
-    DebugLogger::logWithCategory("RAY", "Ray frequencies updated");
+    RIPPLE_LOG(Ray, Trace, "Ray frequencies updated");
 }
 
 void  RayTracer::updateRayCache()
 {
     if (isProcessing)
     {
-        DebugLogger::logWithCategory("TRACER", "Skipping ray cache update because it's already being processed");
+        RIPPLE_LOG(Tracer, Debug, "Skipping ray cache update because it's already being processed");
         return;
     }
-    DebugLogger::logWithCategory("TRACER", "Updating ray cache");
-    isProcessing = true;
+    RIPPLE_LOG(Tracer, Debug, "Updating ray cache");
+
+    // Anything still refining an older scene is now out of date
+    ++latestGeneration;
+
+    const TraceKey key { chamber->getTraceScene(), MAX_REFLECTIONS, transferFieldEnabled };
+
+    publish(findOrTraceScene(key));
+    updateActiveMicrophones(key.scene.activeMicrophones);
+
+    // Not part of a drag, so the scene has settled
+    sharedCache->persist(key);
+    persistWhenRefined = false;
+
+    RIPPLE_LOG(Tracer, Debug, "Ray cache updated");
+}
+
+void RayTracer::updateRayCacheProgressively()
+{
+    RIPPLE_LOG(Tracer, Debug, "Updating ray cache progressively");
+
+    const auto generation = ++latestGeneration;
+    auto scene = chamber->getTraceScene();
+    persistWhenRefined = false;
+
+    // A scene traced before needs no refinement
+    if (const auto cached = findCachedResult({ scene, MAX_REFLECTIONS, transferFieldEnabled }))
+    {
+        publish(cached);
+        updateActiveMicrophones(scene.activeMicrophones);
+        return;
+    }
+
+    // Stage 0: cheap enough to publish straight away
+    publish(std::make_shared<const TraceResult>(estimateScene(scene)));
 
-    // Clear the existing cache
-    cachedRays.clear();
-    std::array<juce::Point<float>, 3> micPositions = chamber->getMicrophonePositions();
-    float speakerX = chamber->getSpeakerX();
-    float speakerY = chamber->getSpeakerY();
+    // Only the newest scene is worth refining; a running job stops at its next stage
+    refinementJobs.cancelPending();
+    refinementJobs.submit([this, scene = std::move(scene), generation, withTransferField = transferFieldEnabled]
+    {
+        refineScene(scene, generation, withTransferField);
+    });
+}
+
+std::vector<Ray> RayTracer::traceRays(const TraceScene& scene, juce::Point<float> speaker, int maxReflections, PathRecords& paths) const
+{
+    std::vector<Ray> rays;
+    const float speakerX = speaker.x;
+    const float speakerY = speaker.y;
 
     // Create primary ray from speaker to each microphone
     for (int micIdx = 0; micIdx < 3; ++micIdx)
     {
-        const auto [x, y] = micPositions[micIdx];
+        const auto [x, y] = scene.microphones[micIdx];
 
         // Calculate direction from speaker to microphone
         juce::Point<float> direction(x - speakerX, y - speakerY);
@@ -428,27 +459,31 @@ void  RayTracer::updateRayCache()
         primaryRay.distance = length;
 
         // Add primary ray to cache
-        cachedRays.push_back(primaryRay);
+        rays.push_back(primaryRay);
 
-        // Trace primary ray and generate reflections
+        // Trace primary ray and generate reflections, remembering each ray's
+        // index so its reflections can be recorded against it
         std::vector<Ray> raysToProcess = {primaryRay};
+        std::vector<int> indicesToProcess = {paths.addPrimaryRay()};
 
         // Limit the number of reflections to prevent infinite loops
-        const int MAX_REFLECTIONS = 100;
         int reflectionCount = 0;
 
-        while (!raysToProcess.empty() && reflectionCount < MAX_REFLECTIONS)
+        while (!raysToProcess.empty() && reflectionCount < maxReflections)
         {
             Ray currentRay = raysToProcess.back();
             raysToProcess.pop_back();
+            const int currentIndex = indicesToProcess.back();
+            indicesToProcess.pop_back();
 
             // Trace ray to find intersection
-            Intersection intersection = traceRay(currentRay);
+            Intersection intersection = traceRay(scene, currentRay);
 
             if (intersection.hit)
             {
                 // Generate reflection rays
-                std::vector<Ray> reflections = generateReflectionRays(currentRay, intersection);
+                std::vector<Ray> reflections = generateReflectionRays(scene, currentRay, intersection);
+                const auto event = intersection.isWall ? PathRecords::WALL : static_cast<int16_t>(intersection.zoneId);
 
                 // Add reflections to rays to process
                 for (auto& reflection : reflections)
@@ -457,7 +492,8 @@ void  RayTracer::updateRayCache()
                     if (reflection.intensity > 0.01f)
                     {
                         raysToProcess.push_back(reflection);
-                        cachedRays.push_back(reflection);
+                        indicesToProcess.push_back(paths.addChildRay(currentIndex, event));
+                        rays.push_back(reflection);
                     }
                 }
 
@@ -466,76 +502,867 @@ void  RayTracer::updateRayCache()
         }
     }
 
+    return rays;
+}
+
+RayTracer::TraceResult RayTracer::evaluateScene(const TraceScene& scene, int maxReflections, bool withTransferField) const
+{
+    jassert(!scene.speakers.empty());
+
+    struct SpeakerTrace
+    {
+        std::vector<Ray> rays;
+        PathRecords paths;
+        SpeakerResult result;
+    };
+
+    std::vector<std::unique_ptr<SpeakerTrace>> traces;
+    for (size_t i = 0; i < scene.speakers.size(); ++i)
+        traces.push_back(std::make_unique<SpeakerTrace>());
+
+    // Speakers' paths are independent, so they are traced side by side against
+    // the one scene copy; a single speaker runs on this thread
+    WorkerPool::parallelFor(WorkerPool::Priority::interactive, static_cast<int>(traces.size()), [&](int speaker)
+    {
+        auto& trace = *traces[static_cast<size_t>(speaker)];
+        const auto position = scene.speakers[static_cast<size_t>(speaker)];
+
+        trace.rays = traceRays(scene, position, maxReflections, trace.paths);
+        trace.result = evaluateSpeaker(scene, position, trace.rays, withTransferField);
+    });
+
+    // Then stitched into one result, with one set of path records to replay
+    TraceResult result;
+    result.maxReflections = maxReflections;
+    auto paths = std::make_shared<PathRecords>();
+
+    for (auto& trace : traces)
+    {
+        trace->result.firstRay = result.rays.size();
+        trace->result.numRays = trace->rays.size();
+
+        result.rays.insert(result.rays.end(), std::make_move_iterator(trace->rays.begin()), std::make_move_iterator(trace->rays.end()));
+        paths->append(trace->paths);
+        result.speakers.push_back(std::move(trace->result));
+    }
+
+    paths->finalise(static_cast<int>(scene.zones.size()));
+    result.paths = std::move(paths);
+    result.decayTimes = fitDecayTimes(result.rays);
+
+    return result;
+}
+
+RayTracer::SpeakerResult RayTracer::evaluateSpeaker(const TraceScene& scene, juce::Point<float> speaker, const std::vector<Ray>& rays, bool withTransferField) const
+{
+    SpeakerResult result;
+
+    // Only active microphones are evaluated; the rest are brought up to date
+    // by updateMicrophone() when they are switched back on
+    for (int mic = 0; mic < 3; ++mic)
+    {
+        if ((scene.activeMicrophones & (1u << mic)) == 0)
+        {
+            RIPPLE_LOG(Tracer, Debug, "Skipping inactive microphone {}", mic);
+            continue;
+        }
+
+        result.micWeights[mic] = computeMicWeights(scene, speaker, rays.data(), rays.size(), scene.microphones[mic]);
+        result.micValues[mic] = mixResponse(result.micWeights[mic], rays.data());
+        result.micEvaluated[mic] = true;
+    }
+
+    if (withTransferField)
+        result.transferField = buildTransferField(scene, speaker, rays.data(), rays.size());
+
+    return result;
+}
+
+RayTracer::TraceResult RayTracer::estimateScene(const TraceScene& scene) const
+{
+    // Statistical model of a diffuse 2D room: walls absorb a fraction alpha of
+    // the energy per reflection, giving an Eyring decay over the mean free
+    // path, and a steady-state diffuse level of 4 / R with room constant
+    // R = perimeter * alpha / (1 - alpha). Zones are ignored at this stage.
+    constexpr float perimeter = 4.0f;   // of the unit chamber
+
+    TraceResult result;
+    std::array<float, MicFrequencyBands::NUM_FREQUENCY_BANDS> diffuseLevels {};
+
+    for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+    {
+        const float absorption = getWallAbsorption(scene, band);
+        const float roomConstant = perimeter * absorption / (1.0f - absorption);
+        diffuseLevels[band] = 4.0f / roomConstant;
+
+        const float decibelsPerBounce = -10.0f * std::log10(1.0f - absorption);
+        result.decayTimes[band] = juce::jmin(MAX_TAIL_SECONDS, 60.0f / decibelsPerBounce * getSecondsPerBounce());
+    }
+
+    for (const auto speaker : scene.speakers)
+    {
+        SpeakerResult speakerResult;
+        speakerResult.firstRay = result.rays.size();
+
+        for (int mic = 0; mic < 3; ++mic)
+        {
+            const auto micPosition = scene.microphones[mic];
+
+            // Primary rays only, so the visualizer has something to draw
+            juce::Point<float> direction = micPosition - speaker;
+            const float distance = direction.getDistanceFromOrigin();
+            if (distance > 0.0f)
+                direction /= distance;
+
+            Ray primaryRay(speaker, direction);
+            primaryRay.distance = distance;
+            result.rays.push_back(primaryRay);
+
+            if ((scene.activeMicrophones & (1u << mic)) == 0)
+                continue;
+
+            // Same direct-path rule as evaluateResponseAt()
+            const Intersection directIntersection = traceRay(scene, primaryRay);
+            const bool directPath = !directIntersection.hit
+                                    || std::abs(directIntersection.distance - distance) < 0.001f;
+            const float direct = directPath ? 1.0f / (1.0f + distance * 5.0f) : 0.0f;
+
+            MicFrequencyBands response;
+            for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+            {
+                response.bands[band].value = direct + diffuseLevels[band];
+            }
+            response.downwardNormalize();
+
+            for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+            {
+                speakerResult.micValues[mic][band] = response.bands[band].value;
+            }
+            speakerResult.micEvaluated[mic] = true;
+        }
+
+        speakerResult.numRays = result.rays.size() - speakerResult.firstRay;
+        result.speakers.push_back(std::move(speakerResult));
+    }
+
+    return result;
+}
+
+void RayTracer::publish(TraceResultPtr result)
+{
+    isProcessing = true;
+
+    // Rays and weights are shared with the result rather than copied; other
+    // instances may have published the same one
+    publishedRays = std::shared_ptr<const std::vector<Ray>>(result, &result->rays);
     raysCacheValid = true;
-    DebugLogger::logWithCategory("TRACER", "Ray cache updated");
 
-    calculateMicrophoneFrequencyResponses();
+    pathRecords = result->paths;
+    publishedReflections = result->maxReflections;
+
+    jassert(!result->speakers.empty() && result->speakers.size() <= static_cast<size_t>(MAX_SPEAKERS));
+    const int numSpeakers = juce::jlimit(1, MAX_SPEAKERS, static_cast<int>(result->speakers.size()));
+
+    for (int speaker = 0; speaker < MAX_SPEAKERS; ++speaker)
+    {
+        if (speaker >= numSpeakers)
+        {
+            micWeights[speaker].fill(nullptr);
+            transferFields[speaker].reset();
+            continue;
+        }
+
+        const auto& speakerResult = result->speakers[static_cast<size_t>(speaker)];
+        speakerRays[speaker] = { speakerResult.firstRay, speakerResult.numRays };
+        transferFields[speaker] = speakerResult.transferField;
+
+        for (int mic = 0; mic < 3; ++mic)
+            micWeights[speaker][mic] = std::shared_ptr<const MicWeights>(result, &speakerResult.micWeights[mic]);
+    }
+
+    for (int mic = 0; mic < 3; ++mic)
+    {
+        // Every speaker's result covers the same microphones
+        if (result->speakers.front().micEvaluated[mic])
+        {
+            for (int speaker = 0; speaker < numSpeakers; ++speaker)
+                applyResponse(speaker, mic, result->speakers[static_cast<size_t>(speaker)].micValues[mic]);
+        }
+        else
+        {
+            micResponseCurrent[mic] = false;
+        }
+    }
+
+    // Coefficients first, so the audio thread never filters a speaker without them
+    publishedSpeakers.store(numSpeakers, std::memory_order_release);
+    responsesPublished.store(true, std::memory_order_release);
+
+    bandDecayTimes = result->decayTimes;
+    cancelTransferFieldRebuild();
+    updateTailLength();
+
+    isProcessing = false;
+    RIPPLE_LOG(Tracer, Debug, "Microphone frequency responses updated");
+   // RIPPLE_LOG(Tracer, Trace, "Frequency response coefficients calculated: {}", micFrequencyResponses[1].toString());
 }
 
-void RayTracer::calculateMicrophoneFrequencyResponses()
+void RayTracer::postResult(TraceResultPtr result, uint32_t generation)
 {
-    DebugLogger::logWithCategory("TRACER", "Updating microphone frequency responses");
+    {
+        const std::lock_guard<std::mutex> lock(pendingLock);
+        pendingResult = std::move(result);
+        pendingGeneration = generation;
+    }
+
+    triggerAsyncUpdate();
+}
+
+void RayTracer::handleAsyncUpdate()
+{
+    TraceResultPtr result;
+    uint32_t generation = 0;
+    TransferFields fields;
+    uint32_t fieldGeneration = 0;
+
+    {
+        const std::lock_guard<std::mutex> lock(pendingLock);
+        result = std::move(pendingResult);
+        generation = pendingGeneration;
+        fields = std::move(pendingFields);
+        fieldGeneration = pendingFieldGeneration;
+    }
 
-    std::array<juce::Point<float>, 3> micPositions = chamber->getMicrophonePositions();
-    float speakerX = chamber->getSpeakerX();
-    float speakerY = chamber->getSpeakerY();
-    DebugLogger::logWithCategory("TRACER", "Init microphone frequency responses");
+    if (fields[0] != nullptr && transferFieldStale && fieldGeneration == transferFieldGeneration)
+    {
+        RIPPLE_LOG(Tracer, Debug, "Rebuilt transfer fields ready");
+        transferFields = std::move(fields);
+        transferFieldStale = false;
+    }
 
-    // Pre-calculate all ray contributions to each microphone
-    for (int mic = 0; mic < 3; ++mic) {
+    // Results of a superseded request are dropped
+    if (result != nullptr && generation == latestGeneration.load())
+    {
+        publish(std::move(result));
 
-        DebugLogger::logWithCategory("TRACER", "Processing microphone " + std::to_string(mic) + "");
-        juce::Point<float> micPosition = micPositions[mic];
+        if (persistWhenRefined && publishedReflections == MAX_REFLECTIONS)
+            persistCurrentScene();
+    }
+}
 
-        // Reset frequency response for this microphone
-        micFrequencyResponses[mic].reset(0.0f);
+void RayTracer::persistCurrentScene()
+{
+    const TraceKey key { chamber->getTraceScene(), MAX_REFLECTIONS, transferFieldEnabled };
 
-        // Direct ray from speaker to microphone
-        juce::Point<float> speakerPosition(speakerX, speakerY);
-        Ray directRay(speakerPosition, micPosition - speakerPosition);
-        directRay.distance = directRay.direction.getDistanceFromOrigin();
+    // Still refining: kept once the full trace arrives
+    persistWhenRefined = !sharedCache->persist(key);
+}
 
-        // Normalize direction
-        if (directRay.distance > 0.0f) {
-            directRay.direction /= directRay.distance;
+RayTracer::TraceResultPtr RayTracer::findCachedResult(const TraceKey& key)
+{
+    return sharedCache->find(key);
+}
+
+RayTracer::TraceResultPtr RayTracer::findOrTraceScene(const TraceKey& key) const
+{
+    // Instances asking for the same scene at once share a single trace
+    return sharedCache->findOrCompute(key, [this, &key]
+    {
+        return std::make_shared<const TraceResult>(evaluateScene(key.scene, key.maxReflections, key.withTransferField));
+    });
+}
+
+void RayTracer::updateActiveMicrophones(uint32_t activeMicrophones)
+{
+    // A cached result may predate a microphone being switched on
+    for (int mic = 0; mic < 3; ++mic)
+    {
+        if ((activeMicrophones & (1u << mic)) != 0)
+            updateMicrophone(mic);
+    }
+}
+
+bool TraceScene::hasSameInputs(const TraceScene& other) const
+{
+    if (speakers != other.speakers || microphones != other.microphones
+        || defaultDensity != other.defaultDensity || wallReflectivity != other.wallReflectivity
+        || wallDamping != other.wallDamping || zones.size() != other.zones.size())
+        return false;
+
+    return std::equal(zones.begin(), zones.end(), other.zones.begin());
+}
+
+uint64_t TraceScene::hashInputs() const
+{
+    // FNV-1a over the bit patterns of every value compared by hasSameInputs()
+    uint64_t hash = 14695981039346656037ull;
+
+    const auto mix = [&hash](float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        for (int byte = 0; byte < 4; ++byte)
+        {
+            hash ^= (bits >> (byte * 8)) & 0xffu;
+            hash *= 1099511628211ull;
         }
+    };
+
+    mix(static_cast<float>(speakers.size()));
+    for (const auto& speaker : speakers)
+    {
+        mix(speaker.x);
+        mix(speaker.y);
+    }
 
-        // Check if there's a direct path
-        Intersection directIntersection = traceRay(directRay);
+    for (const auto& mic : microphones)
+    {
+        mix(mic.x);
+        mix(mic.y);
+    }
+
+    mix(defaultDensity);
+    mix(wallReflectivity);
+    mix(wallDamping);
+
+    for (const auto& zone : zones)
+    {
+        mix(zone.x);
+        mix(zone.y);
+        mix(zone.width);
+        mix(zone.height);
+        mix(zone.density);
+    }
+
+    return hash;
+}
+
+size_t RayTracer::TraceKeyHash::operator()(const TraceKey& key) const noexcept
+{
+    const auto quality = static_cast<uint64_t>(key.maxReflections) * 2u + (key.withTransferField ? 1u : 0u);
+    return static_cast<size_t>(key.scene.hashInputs() ^ (quality * 0x9e3779b97f4a7c15ull));
+}
 
-        // If the direct ray doesn't hit anything before reaching the microphone
-        // or if it hits exactly at the microphone position
-        if (!directIntersection.hit ||
-            std::abs(directIntersection.distance - directRay.distance) < 0.001f) {
-            // Direct contribution with distance attenuation
-            float attenuation = 1.0f / (1.0f + directRay.distance * 5.0f);
+void RayTracer::calculateMicrophoneFrequencyResponse(int mic)
+{
+    RIPPLE_LOG(Tracer, Debug, "Processing microphone {}", mic);
+
+    // The weights are kept so later parameter changes can be replayed for this mic
+    const auto scene = chamber->getTraceScene();
+
+    for (int speaker = 0; speaker < getNumSpeakers(); ++speaker)
+    {
+        micWeights[speaker][mic] = computePublishedMicWeights(scene, speaker, mic);
+        applyResponse(speaker, mic, mixResponse(*micWeights[speaker][mic], publishedRays->data() + speakerRays[speaker].first));
+    }
+}
+
+std::shared_ptr<const RayTracer::MicWeights> RayTracer::computePublishedMicWeights(const TraceScene& scene, int speaker, int mic) const
+{
+    jassert(static_cast<size_t>(speaker) < scene.speakers.size());
+    const auto position = scene.speakers[juce::jmin(static_cast<size_t>(speaker), scene.speakers.size() - 1)];
+    const auto& range = speakerRays[speaker];
+
+    return std::make_shared<const MicWeights>(computeMicWeights(scene, position, publishedRays->data() + range.first, range.size, scene.microphones[mic]));
+}
+
+MicFrequencyBands::BandValues RayTracer::evaluateResponseAt(const TraceScene& scene, juce::Point<float> speaker, const Ray* rays, size_t numRays, juce::Point<float> micPosition) const
+{
+    return mixResponse(computeMicWeights(scene, speaker, rays, numRays, micPosition), rays);
+}
+
+RayTracer::MicWeights RayTracer::computeMicWeights(const TraceScene& scene, juce::Point<float> speaker, const Ray* rays, size_t numRays, juce::Point<float> micPosition) const
+{
+    float speakerX = speaker.x;
+    float speakerY = speaker.y;
+
+    MicWeights weights;
+    weights.position = micPosition;
+    weights.rays.assign(numRays, 0.0f);
+
+    // Direct ray from speaker to microphone
+    juce::Point<float> speakerPosition(speakerX, speakerY);
+    Ray directRay(speakerPosition, micPosition - speakerPosition);
+    directRay.distance = directRay.direction.getDistanceFromOrigin();
+
+    // Normalize direction
+    if (directRay.distance > 0.0f) {
+        directRay.direction /= directRay.distance;
+    }
+
+    // Check if there's a direct path
+    Intersection directIntersection = traceRay(scene, directRay);
+
+    // If the direct ray doesn't hit anything before reaching the microphone
+    // or if it hits exactly at the microphone position
+    if (!directIntersection.hit ||
+        std::abs(directIntersection.distance - directRay.distance) < 0.001f) {
+        // Direct contribution with distance attenuation, applied to all frequency bands
+        weights.direct = 1.0f / (1.0f + directRay.distance * 5.0f);
+    }
 
-            // Apply direct contribution to all frequency bands
-            micFrequencyResponses[mic] += attenuation;
+    // Contribution of each cached ray; only the rays' band gains are left to apply
+    for (size_t i = 0; i < numRays; ++i) {
+        if (rays[i].intensity > 0.01f) { // Skip rays with negligible intensity
+            weights.rays[i] = juce::jmax(0.0f, calculateRayContribution(rays[i], micPosition));
         }
+    }
 
-        // Add contributions from all cached rays to specific frequency bands
-        for (const auto& ray : cachedRays) {
-            if (ray.intensity > 0.01f) { // Skip rays with negligible intensity
-                // Calculate contribution for this ray
-                float baseContribution = calculateRayContribution(ray, micPosition);
+    return weights;
+}
 
-                if (baseContribution > 0.0f) {
-                    micFrequencyResponses[mic]  += ray.frequencyBands * baseContribution;
-                }
-            }
+MicFrequencyBands::BandValues RayTracer::mixResponse(const MicWeights& weights, const Ray* rays)
+{
+    MicFrequencyBands response;
+    response.reset(weights.direct);
+
+    for (size_t i = 0; i < weights.rays.size(); ++i) {
+        if (weights.rays[i] > 0.0f) {
+            response += rays[i].frequencyBands * weights.rays[i];
+        }
+    }
+
+    // Normalize frequency responses to avoid excessive gain
+    response.downwardNormalize();
+
+    MicFrequencyBands::BandValues values {};
+    for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+    {
+        values[band] = response.bands[band].value;
+    }
+
+    return values;
+}
+
+bool RayTracer::replayParameters()
+{
+    // Only a finished full trace has records worth replaying; while a
+    // progressive update is refining, its last stage will use the new values
+    if (!raysCacheValid || isProcessing || pathRecords == nullptr || publishedReflections != MAX_REFLECTIONS
+        || pathRecords->getNumRays() != publishedRays->size())
+        return false;
+
+    const auto scene = chamber->getTraceScene();
+    const int numSpeakers = getNumSpeakers();
+    if (static_cast<int>(scene.zones.size()) != pathRecords->getNumZones()
+        || static_cast<int>(scene.speakers.size()) != numSpeakers)
+        return false;
+
+    RIPPLE_LOG(Tracer, Debug, "Replaying {} paths for new wall and medium parameters", static_cast<int>(publishedRays->size()));
+
+    isProcessing = true;
+
+    pathRecords->replay(getEventFactors(scene), replayGains);
+
+    // The published rays may be shared, so new band values go into this
+    // instance's own copy, made on the first replay after each publish
+    if (replayedRays == nullptr)
+        replayedRays = std::make_shared<std::vector<Ray>>();
+
+    if (publishedRays != replayedRays)
+    {
+        *replayedRays = *publishedRays;
+        publishedRays = replayedRays;
+    }
+
+    auto& rays = *replayedRays;
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+            rays[i].frequencyBands.bands[band].value = replayGains[band][i];
+    }
+
+    for (int mic = 0; mic < 3; ++mic)
+    {
+        if ((scene.activeMicrophones & (1u << mic)) == 0)
+        {
+            micResponseCurrent[mic] = false;
+            continue;
         }
 
-        // Normalize frequency responses to avoid excessive gain
-        micFrequencyResponses[mic].downwardNormalize();
-        micFrequencyResponses[mic].bands[0].value = 0;
-        micFrequencyResponses[mic].bands[1].value = 0;
-        micFrequencyResponses[mic].bands[2].value = 0;
-        micFrequencyResponses[mic].calculateBiquadCoefficients(chamber->getSampleRate());
+        for (int speaker = 0; speaker < numSpeakers; ++speaker)
+        {
+            // A mic moved by transfer field lookup needs weights for where it is now
+            auto& weights = micWeights[speaker][mic];
+            if (weights == nullptr || weights->rays.size() != speakerRays[speaker].size || weights->position != scene.microphones[mic])
+                weights = computePublishedMicWeights(scene, speaker, mic);
+
+            applyResponse(speaker, mic, mixResponse(*weights, rays.data() + speakerRays[speaker].first));
+        }
     }
 
+    bandDecayTimes = fitDecayTimes(rays);
+
+    // Rebuilt in the background; mic moves retrace until the fields are back
+    if (transferFields[0] != nullptr || transferFieldStale)
+    {
+        for (auto& field : transferFields)
+            field.reset();
+        transferFieldStale = true;
+        scheduleTransferFieldRebuild();
+    }
+
+    updateTailLength();
+
     isProcessing = false;
-    DebugLogger::logWithCategory("TRACER", "Microphone frequency responses updated");
-   // DebugLogger::logWithCategory("TRACER", "Frequency response coefficients calculated: " + micFrequencyResponses[1].toString());
+    return true;
+}
+
+void RayTracer::applyResponse(int speaker, int mic, const MicFrequencyBands::BandValues& values)
+{
+    // Only the values and coefficients change; the filter state carries on
+    appliedResponses[speaker][mic] = values;
+
+    auto& response = micFrequencyResponses[speaker][mic];
+    for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+    {
+        response.bands[band].value = values[band];
+    }
+
+    response.bands[0].value = 0;
+    response.bands[1].value = 0;
+    response.bands[2].value = 0;
+
+    // The coefficients are rewritten in place, so the audio thread must not
+    // copy them until the sequence is even again
+    const auto sequence = coefficientSequence.load(std::memory_order_relaxed);
+    coefficientSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    response.calculateBiquadCoefficients(chamber->getSampleRate());
+
+    coefficientSequence.store(sequence + 2, std::memory_order_release);
+
+    micResponseCurrent[mic] = true;
+}
+
+bool RayTracer::copyFilterCoefficients(int speaker, int mic, MicFrequencyBands& filters) const noexcept
+{
+    const auto& source = micFrequencyResponses[speaker][mic];
+
+    for (int attempt = 0; attempt < MAX_COEFFICIENT_READ_ATTEMPTS; ++attempt)
+    {
+        const auto before = coefficientSequence.load(std::memory_order_acquire);
+        if ((before & 1u) != 0)
+            continue;
+
+        std::array<Biquad, MicFrequencyBands::NUM_FREQUENCY_BANDS> copied;
+        for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+            copied[band] = source.bands[band].biquad;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (coefficientSequence.load(std::memory_order_relaxed) != before)
+            continue;
+
+        for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+        {
+            auto& biquad = filters.bands[band].biquad;
+            biquad.a0 = copied[band].a0;
+            biquad.a1 = copied[band].a1;
+            biquad.a2 = copied[band].a2;
+            biquad.b0 = copied[band].b0;
+            biquad.b1 = copied[band].b1;
+            biquad.b2 = copied[band].b2;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool RayTracer::publishBakedResponses(const std::vector<MicBandValues>& responses)
+{
+    const auto scene = chamber->getTraceScene();
+    if (responses.empty() || responses.size() != scene.speakers.size())
+        return false;
+
+    RIPPLE_LOG(Tracer, Debug, "Publishing baked microphone responses for {} speakers", static_cast<int>(responses.size()));
+
+    // Anything still refining an older scene is now out of date
+    ++latestGeneration;
+    persistWhenRefined = false;
+
+    // The estimate supplies the direct rays and decay times; the saved values the responses
+    auto result = estimateScene(scene);
+    for (size_t speaker = 0; speaker < result.speakers.size(); ++speaker)
+    {
+        for (int mic = 0; mic < 3; ++mic)
+        {
+            result.speakers[speaker].micValues[mic] = responses[speaker][mic];
+            result.speakers[speaker].micEvaluated[mic] = true;
+        }
+    }
+
+    publish(std::make_shared<const TraceResult>(std::move(result)));
+    return true;
+}
+
+std::unique_ptr<TransferField> RayTracer::buildTransferField(const TraceScene& scene, juce::Point<float> speaker, const Ray* rays, size_t numRays) const
+{
+    RIPPLE_LOG(Tracer, Debug, "Building transfer field ({} x {} positions)", TransferField::GRID_SIZE, TransferField::GRID_SIZE);
+
+    auto field = std::make_unique<TransferField>();
+    field->build([this, &scene, speaker, rays, numRays](juce::Point<float> position)
+    {
+        return evaluateResponseAt(scene, speaker, rays, numRays, position);
+    });
+
+    RIPPLE_LOG(Tracer, Debug, "Transfer field built");
+    return field;
+}
+
+void RayTracer::scheduleTransferFieldRebuild()
+{
+    const auto generation = ++transferFieldGeneration;
+    const auto scene = chamber->getTraceScene();
+    const int numSpeakers = juce::jmin(getNumSpeakers(), static_cast<int>(scene.speakers.size()));
+
+    // The next replay rewrites the published rays in place, so the job gets its own copy
+    auto rays = std::make_shared<const std::vector<Ray>>(*publishedRays);
+
+    transferFieldJobs.cancelPending();
+    transferFieldJobs.submit([this, scene, numSpeakers, rays = std::move(rays), ranges = speakerRays, generation]
+    {
+        TransferFields fields;
+        for (int speaker = 0; speaker < numSpeakers; ++speaker)
+        {
+            const auto& range = ranges[static_cast<size_t>(speaker)];
+            fields[static_cast<size_t>(speaker)] = buildTransferField(scene, scene.speakers[static_cast<size_t>(speaker)],
+                                                                      rays->data() + range.first, range.size);
+        }
+
+        postTransferFields(std::move(fields), generation);
+    });
+}
+
+void RayTracer::cancelTransferFieldRebuild()
+{
+    // Whatever is still building belongs to an older result
+    ++transferFieldGeneration;
+    transferFieldJobs.cancelPending();
+    transferFieldStale = false;
+}
+
+void RayTracer::postTransferFields(TransferFields fields, uint32_t generation)
+{
+    {
+        const std::lock_guard<std::mutex> lock(pendingLock);
+        pendingFields = std::move(fields);
+        pendingFieldGeneration = generation;
+    }
+
+    triggerAsyncUpdate();
+}
+
+bool RayTracer::updateMicrophoneFromTransferField(int mic)
+{
+    // Still rebuilding after a replay
+    if (transferFieldStale)
+        return false;
+
+    const int numSpeakers = getNumSpeakers();
+    for (int speaker = 0; speaker < numSpeakers; ++speaker)
+    {
+        if (transferFields[speaker] == nullptr || !transferFields[speaker]->isValid())
+            return false;
+    }
+
+    const auto position = chamber->getMicrophonePosition(mic);
+    for (int speaker = 0; speaker < numSpeakers; ++speaker)
+        applyResponse(speaker, mic, transferFields[speaker]->lookup(position));
+
+    return true;
+}
+
+void RayTracer::setTransferFieldEnabled(bool enabled)
+{
+    transferFieldEnabled = enabled;
+
+    if (!enabled)
+    {
+        cancelTransferFieldRebuild();
+        for (auto& field : transferFields)
+            field.reset();
+    }
+    else if (raysCacheValid && transferFields[0] == nullptr && !transferFieldStale)
+    {
+        transferFieldStale = true;
+        scheduleTransferFieldRebuild();
+    }
+}
+
+void RayTracer::updateSampleRate()
+{
+    for (int mic = 0; mic < 3; ++mic)
+    {
+        if (!micResponseCurrent[mic])
+            continue;
+
+        for (int speaker = 0; speaker < getNumSpeakers(); ++speaker)
+            applyResponse(speaker, mic, appliedResponses[speaker][mic]);
+    }
+
+    updateTailLength();
+}
+
+void RayTracer::updateMicrophone(int mic)
+{
+    if (!raysCacheValid || isProcessing || micResponseCurrent[mic])
+        return;
+
+    RIPPLE_LOG(Tracer, Debug, "Bringing microphone {} up to date", mic);
+
+    if (!updateMicrophoneFromTransferField(mic))
+        calculateMicrophoneFrequencyResponse(mic);
+    updateTailLength();
+}
+
+float RayTracer::getWallAbsorption(const TraceScene& scene, int band)
+{
+    // Walls absorb high frequencies more than low frequencies. Reflectivity
+    // sets the broadband loss and damping the extra loss per decade; the
+    // default parameters (0.5, 0.2) give 0.1 + 0.05 per decade.
+    float freq = 100.0f * std::pow(2.0f, band); // Approximate frequency for this band
+    const float broadband = 0.4f * (1.0f - scene.wallReflectivity) * (1.0f - scene.wallReflectivity);
+    const float highFrequency = 0.25f * scene.wallDamping * std::log10(freq / 100.0f);
+    return juce::jlimit(0.01f, 0.95f, broadband + highFrequency);
+}
+
+float RayTracer::getZoneTransmission(const TraceScene& scene, const Zone& zone, int band)
+{
+    // Calculate impedance ratio
+    float z1 = scene.defaultDensity; // Default medium density of the chamber
+    float z2 = zone.density; // Zone impedance
+
+    // Frequency-dependent transmission coefficient
+    // Higher frequencies are more affected by density changes
+    float freq = 100.0f * std::pow(2.0f, band); // Approximate frequency for this band
+    float freqFactor = 0.5f + 0.5f * std::log10(freq / 100.0f) / 3.0f;
+    float densityDiff = std::abs(z2 - z1) * freqFactor;
+
+    // Transmission coefficient (simplified model)
+    float T = 1.0f - densityDiff / (z1 + z2);
+    return juce::jlimit(0.1f, 1.0f, T); // Limit to reasonable range
+}
+
+PathRecords::EventFactors RayTracer::getEventFactors(const TraceScene& scene)
+{
+    PathRecords::EventFactors factors;
+    factors.zones.resize(scene.zones.size());
+
+    for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+    {
+        factors.wall[band] = 1.0f - getWallAbsorption(scene, band);
+
+        for (size_t zone = 0; zone < scene.zones.size(); ++zone)
+            factors.zones[zone][band] = getZoneTransmission(scene, scene.zones[zone], band);
+    }
+
+    return factors;
+}
+
+float RayTracer::getSecondsPerBounce()
+{
+    // Mean free path of the chamber (pi * area / perimeter) at the speed of sound
+    const float meanFreePath = juce::MathConstants<float>::pi * NOMINAL_SIZE_METRES / 4.0f;
+    return meanFreePath / SPEED_OF_SOUND;
+}
+
+RayTracer::BandDecayTimes RayTracer::fitDecayTimes(const std::vector<Ray>& rays)
+{
+    // Fit the per-band energy of the rays against bounce count: the slope is
+    // the decay per reflection, and the mean free path turns reflections into time
+    const float secondsPerBounce = getSecondsPerBounce();
+    BandDecayTimes decayTimes {};
+
+    for (int band = 0; band < MicFrequencyBands::NUM_FREQUENCY_BANDS; ++band)
+    {
+        double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+        int count = 0;
+
+        for (const auto& ray : rays)
+        {
+            const float energy = ray.intensity * ray.frequencyBands.bands[band].value;
+            if (energy <= 0.0f)
+                continue;
+
+            const double x = ray.bounceCount;
+            const double y = 10.0 * std::log10(energy);
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+            ++count;
+        }
+
+        const double denominator = count * sumXX - sumX * sumX;
+        const double decibelsPerBounce = denominator > 0.0 ? (count * sumXY - sumX * sumY) / denominator : 0.0;
+
+        decayTimes[band] = decibelsPerBounce < 0.0
+                               ? juce::jmin(MAX_TAIL_SECONDS, static_cast<float>(-60.0 / decibelsPerBounce) * secondsPerBounce)
+                               : 0.0f;
+    }
+
+    return decayTimes;
+}
+
+void RayTracer::updateTailLength()
+{
+    float longestDecay = *std::max_element(bandDecayTimes.begin(), bandDecayTimes.end());
+
+    // The filters themselves also ring; take the slowest pole of any band
+    const double sampleRate = chamber->getSampleRate();
+
+    for (int mic = 0; mic < 3; ++mic)
+    {
+        if (!micResponseCurrent[mic])
+            continue;
+
+        for (int speaker = 0; speaker < getNumSpeakers(); ++speaker)
+        {
+            for (const auto& band : micFrequencyResponses[speaker][mic].bands)
+            {
+                const double poleRadius = band.getPoleRadius();
+
+                if (poleRadius >= 1.0)
+                {
+                    longestDecay = MAX_TAIL_SECONDS;
+                }
+                else if (poleRadius > 0.0 && sampleRate > 0.0)
+                {
+                    const double ringSamples = std::log(0.001) / std::log(poleRadius);
+                    longestDecay = juce::jmax(longestDecay, static_cast<float>(ringSamples / sampleRate));
+                }
+            }
+        }
+    }
+
+    tailLengthSeconds.store(juce::jmin(MAX_TAIL_SECONDS, longestDecay), std::memory_order_relaxed);
+
+    RIPPLE_LOG(Tracer, Debug, "Estimated RT60 {} / {} / {} s, tail {} s",
+               bandDecayTimes[0], bandDecayTimes[1], bandDecayTimes[2], tailLengthSeconds.load());
+}
+
+//==============================================================================
+void RayTracer::refineScene(const TraceScene& scene, uint32_t generation, bool withTransferField)
+{
+    for (size_t stage = 0; stage < PROGRESSIVE_REFLECTIONS.size(); ++stage)
+    {
+        // A newer scene (or a synchronous update) makes this one pointless
+        if (generation != latestGeneration.load())
+            return;
+
+        const bool finalStage = stage == PROGRESSIVE_REFLECTIONS.size() - 1;
+        const TraceKey key { scene, PROGRESSIVE_REFLECTIONS[stage], finalStage && withTransferField };
+
+        // Only full traces are worth sharing and revisiting
+        auto result = key.maxReflections == MAX_REFLECTIONS
+                          ? findOrTraceScene(key)
+                          : std::make_shared<const TraceResult>(evaluateScene(key.scene, key.maxReflections, key.withTransferField));
+
+        RIPPLE_LOG(Tracer, Debug, "Refinement stage {} ready ({} rays)", static_cast<int>(stage + 1), static_cast<int>(result->rays.size()));
+        postResult(std::move(result), generation);
+    }
 }
 //processBlock called (iteration 1)
\ No newline at end of file
@@ -3,7 +3,14 @@
 #include <JuceHeader.h>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "MicFrequencyBands.h"
+#include "TransferField.h"
+#include "PathRecords.h"
+#include "Zone.h"
+#include "../Utils/WorkerPool.h"
 
 // forward declaration
 class Chamber;
@@ -38,22 +45,201 @@ struct Intersection {
     int zoneId = -1;
 };
 
-class RayTracer
+/**
+ * Everything the tracer reads from the chamber, copied so a trace can run on
+ * a background thread while the scene keeps changing.
+ */
+struct TraceScene
+{
+    static constexpr int MAX_SPEAKERS = 4;
+
+    std::vector<juce::Point<float>> speakers { { 0.5f, 0.5f } };    // at least one
+    std::array<juce::Point<float>, 3> microphones;
+    std::vector<Zone> zones;
+    float defaultDensity = 1.0f;
+    float wallReflectivity = 0.5f;
+    float wallDamping = 0.2f;
+    uint32_t activeMicrophones = 0x7;
+
+    /** Equality and hash of everything a trace result depends on (not which mics are active). */
+    bool hasSameInputs(const TraceScene& other) const;
+    uint64_t hashInputs() const;
+};
+
+class SharedTraceCache;
+
+class RayTracer : private juce::AsyncUpdater
 {
 public:
     RayTracer();
-    ~RayTracer();
+    ~RayTracer() override;
 
     void initialize(Chamber* parentChamber);
 
 
-    bool RayTracer::isCacheValid() const { return initialized && raysCacheValid && !isProcessing; }
-    const std::vector<Ray>& getCachedRays() const { return cachedRays; }
-    std::array<MicFrequencyBands, 3>& getMicFrequencyResponses()  { return micFrequencyResponses; }
+    static constexpr int MAX_SPEAKERS = TraceScene::MAX_SPEAKERS;
+
+    /**
+     * True once a first set of responses has been published; from then on the
+     * audio thread can always filter, since coefficients being rewritten are
+     * never copied half-way (see copyFilterCoefficients()). Any thread.
+     */
+    bool hasPublishedResponses() const noexcept { return responsesPublished.load(std::memory_order_acquire); }
+    const std::vector<Ray>& getCachedRays() const { return *publishedRays; }
+
+    /** Each mic's response to one speaker (message thread; the audio thread uses copyFilterCoefficients()). */
+    std::array<MicFrequencyBands, 3>& getMicFrequencyResponses(int speaker = 0) { return micFrequencyResponses[speaker]; }
+
+    /**
+     * Copy the coefficients of a mic's filters for one speaker into filters,
+     * leaving their state alone. The message thread may be rewriting them
+     * meanwhile; a set it is half-way through is never copied, and if no
+     * consistent set can be read after a few attempts filters keep what they
+     * had and this returns false. Never blocks (audio thread).
+     */
+    bool copyFilterCoefficients(int speaker, int mic, MicFrequencyBands& filters) const noexcept;
+
+    /** Number of speakers in the published responses; safe to read from any thread. */
+    int getNumSpeakers() const { return publishedSpeakers.load(std::memory_order_acquire); }
+
+    /**
+     * Re-evaluate the published paths for changed wall or medium parameters
+     * (reflectivity, damping, default and zone densities) by replaying their
+     * path records. Returns false if a retrace is needed instead, e.g. because
+     * the published result is still being refined.
+     */
+    bool replayParameters();
+
+    /**
+     * Full trace of the current scene, published before returning. Every
+     * speaker is traced in the same pass, concurrently on the shared workers,
+     * into one result with one set of path records. Traces are
+     * shared by every instance in the process and recently traced scenes are
+     * remembered, so returning to one (e.g. by undo), or loading a scene
+     * another instance already has, is a cache hit instead of a retrace.
+     */
     void updateRayCache();
 
+    /**
+     * Publish a statistical estimate of the current scene immediately (direct
+     * paths plus an Eyring diffuse tail), then refine it with increasingly
+     * dense traces on the shared worker pool. Each stage is published on the
+     * message thread as soon as it is ready; a newer request abandons older ones.
+     */
+    void updateRayCacheProgressively();
+
+    /**
+     * Keep the current scene's full trace on disk, so reopening the session
+     * finds it traced. Call once the scene has settled, e.g. when a gesture
+     * ends; a full trace still being refined is kept when it is published.
+     * Synchronous updateRayCache() results are kept anyway.
+     */
+    void persistCurrentScene();
+
+    // Recompute the current responses' filter coefficients for the chamber's new sample rate
+    void updateSampleRate();
+
+    // Evaluate a microphone skipped by the last update because it was inactive
+    void updateMicrophone(int mic);
+    bool isMicrophoneCurrent(int mic) const { return micResponseCurrent[mic]; }
+
+    /**
+     * When enabled, every retrace also evaluates the responses over a grid of
+     * mic positions, so updateMicrophoneFromTransferField() can move a mic
+     * without retracing. Fields invalidated by a parameter replay are rebuilt
+     * on a background worker.
+     */
+    void setTransferFieldEnabled(bool enabled);
+
+    // Set a mic's response from the transfer field; false if there is no valid field (yet)
+    bool updateMicrophoneFromTransferField(int mic);
+
+    /**
+     * Band values behind each mic's current filters, and a way to publish
+     * saved ones (one set per speaker of the chamber's current scene) in place
+     * of a trace, so a restored session is heard without tracing. Like an
+     * estimate they come with the direct rays only and no path records or
+     * transfer field, so the next edit retraces. Returns false if the
+     * responses don't fit the scene.
+     */
+    using MicBandValues = std::array<MicFrequencyBands::BandValues, 3>;
+    const MicFrequencyBands::BandValues& getAppliedResponse(int speaker, int mic) const { return appliedResponses[speaker][mic]; }
+    bool publishBakedResponses(const std::vector<MicBandValues>& responses);
+
+    // Per-band RT60 estimated from the traced reflections, in seconds
+    const std::array<float, MicFrequencyBands::NUM_FREQUENCY_BANDS>& getBandDecayTimes() const { return bandDecayTimes; }
+
+    // Time for the response to decay by 60 dB once the input stops; safe to read from any thread
+    float getTailLengthSeconds() const { return tailLengthSeconds.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Trace results, shared with the process-wide and on-disk caches and, once
+    // published, between instances; immutable once built
+
+    using BandDecayTimes = std::array<float, MicFrequencyBands::NUM_FREQUENCY_BANDS>;
+
+    /** How much each ray reaches one microphone; independent of the wall and medium parameters. */
+    struct MicWeights
+    {
+        juce::Point<float> position;
+        float direct = 0.0f;
+        std::vector<float> rays;
+    };
+
+    /** One speaker's part of a trace; its rays are rays[firstRay, firstRay + numRays) of the result. */
+    struct SpeakerResult
+    {
+        size_t firstRay = 0;
+        size_t numRays = 0;
+        MicBandValues micValues {};
+        std::array<MicWeights, 3> micWeights;     // over this speaker's rays only
+        std::array<bool, 3> micEvaluated {};
+        std::shared_ptr<const TransferField> transferField;
+    };
+
+    /** The outcome of evaluating one scene, built off the message thread and then published. */
+    struct TraceResult
+    {
+        std::vector<Ray> rays;                      // every speaker's, in speaker order
+        std::shared_ptr<const PathRecords> paths;   // null for statistical estimates
+        int maxReflections = 0;
+        std::vector<SpeakerResult> speakers;
+        BandDecayTimes decayTimes {};
+    };
+
+    using TraceResultPtr = std::shared_ptr<const TraceResult>;
+
+    /** Identifies a trace: the scene geometry plus the quality it was traced at. */
+    struct TraceKey
+    {
+        TraceScene scene;
+        int maxReflections = MAX_REFLECTIONS;
+        bool withTransferField = false;
+
+        bool operator==(const TraceKey& other) const
+        {
+            return maxReflections == other.maxReflections
+                   && withTransferField == other.withTransferField
+                   && scene.hasSameInputs(other.scene);
+        }
+    };
+
+    struct TraceKeyHash
+    {
+        size_t operator()(const TraceKey& key) const noexcept;
+    };
+
 private:
     static constexpr int RAYS_PER_REFLECTION = 3;
+    static constexpr int MAX_REFLECTIONS = 100;
+
+    // Reflection budgets of the progressive refinement stages; the last is a full trace
+    static constexpr std::array<int, 3> PROGRESSIVE_REFLECTIONS { 8, 30, MAX_REFLECTIONS };
+
+    // The chamber is modelled in normalised units; this sets the time scale for decay estimates
+    static constexpr float NOMINAL_SIZE_METRES = 10.0f;
+    static constexpr float SPEED_OF_SOUND = 343.0f;
+    static constexpr float MAX_TAIL_SECONDS = 30.0f;
 
     bool initialized;
     bool isProcessing;
@@ -63,23 +249,99 @@ private:
 
     // Ray tracing
     bool raysCacheValid;
-    std::vector<Ray> cachedRays;
+    std::shared_ptr<const std::vector<Ray>> publishedRays;   // the published result's rays until a replay
+    std::shared_ptr<std::vector<Ray>> replayedRays;           // this instance's copy with replayed band values
+
+    // Per speaker, then per mic. A mic is current when its responses to every speaker are
+    std::array<std::array<MicFrequencyBands, 3>, MAX_SPEAKERS> micFrequencyResponses;
+    std::array<bool, 3> micResponseCurrent {};
+    std::array<MicBandValues, MAX_SPEAKERS> appliedResponses {};
+    std::atomic<int> publishedSpeakers { 1 };
+    std::atomic<bool> responsesPublished { false };
+
+    // Seqlock over the coefficients in micFrequencyResponses: odd while applyResponse() is writing
+    static constexpr int MAX_COEFFICIENT_READ_ATTEMPTS = 4;
+    std::atomic<uint32_t> coefficientSequence { 0 };
+
+    // Where each published speaker's rays are in publishedRays
+    struct RayRange
+    {
+        size_t first = 0;
+        size_t size = 0;
+    };
+    std::array<RayRange, MAX_SPEAKERS> speakerRays {};
+
+    std::array<std::shared_ptr<const TransferField>, MAX_SPEAKERS> transferFields;
+    bool transferFieldEnabled = false;
+
+    BandDecayTimes bandDecayTimes {};
+    std::atomic<float> tailLengthSeconds { 0.0f };
+
+    // Path records of the published rays, for replaying parameter changes
+    std::shared_ptr<const PathRecords> pathRecords;
+    int publishedReflections = 0;
+    std::array<std::array<std::shared_ptr<const MicWeights>, 3>, MAX_SPEAKERS> micWeights;
+    PathRecords::BandGains replayGains;
+    bool transferFieldStale = false;
+
+    // Progressive refinement runs on the shared workers; results are handed to
+    // the message thread through pendingResult
+    WorkerPool::JobGroup refinementJobs { WorkerPool::Priority::interactive };
+    std::atomic<uint32_t> latestGeneration { 0 };
+    std::mutex pendingLock;
+    TraceResultPtr pendingResult;
+    uint32_t pendingGeneration = 0;
+    bool persistWhenRefined = false;
+
+    // Transfer fields rebuilt after a replay, handed over like pendingResult.
+    // Only the latest request's fields are taken; a publish supersedes them.
+    using TransferFields = std::array<std::shared_ptr<const TransferField>, MAX_SPEAKERS>;
+    WorkerPool::JobGroup transferFieldJobs { WorkerPool::Priority::background };
+    uint32_t transferFieldGeneration = 0;
+    TransferFields pendingFields;
+    uint32_t pendingFieldGeneration = 0;
+
+    // Completed full traces, shared with the refinement thread and every other instance
+    juce::SharedResourcePointer<SharedTraceCache> sharedCache;
+
+    void handleAsyncUpdate() override;
+    void publish(TraceResultPtr result);
+    void postResult(TraceResultPtr result, uint32_t generation);
+    TraceResultPtr findCachedResult(const TraceKey& key);
+    TraceResultPtr findOrTraceScene(const TraceKey& key) const;
+    void updateActiveMicrophones(uint32_t activeMicrophones);
+    void refineScene(const TraceScene& scene, uint32_t generation, bool withTransferField);
 
-    std::array<MicFrequencyBands, 3> micFrequencyResponses;
+    // Pure evaluation: safe to call from the refinement thread. Functions of one
+    // speaker take that speaker's rays only (numRays of them from rays)
+    std::vector<Ray> traceRays(const TraceScene& scene, juce::Point<float> speaker, int maxReflections, PathRecords& paths) const;
+    TraceResult evaluateScene(const TraceScene& scene, int maxReflections, bool withTransferField) const;
+    SpeakerResult evaluateSpeaker(const TraceScene& scene, juce::Point<float> speaker, const std::vector<Ray>& rays, bool withTransferField) const;
+    TraceResult estimateScene(const TraceScene& scene) const;
+    MicFrequencyBands::BandValues evaluateResponseAt(const TraceScene& scene, juce::Point<float> speaker, const Ray* rays, size_t numRays, juce::Point<float> micPosition) const;
+    MicWeights computeMicWeights(const TraceScene& scene, juce::Point<float> speaker, const Ray* rays, size_t numRays, juce::Point<float> micPosition) const;
+    static MicFrequencyBands::BandValues mixResponse(const MicWeights& weights, const Ray* rays);
+    std::unique_ptr<TransferField> buildTransferField(const TraceScene& scene, juce::Point<float> speaker, const Ray* rays, size_t numRays) const;
+    std::shared_ptr<const MicWeights> computePublishedMicWeights(const TraceScene& scene, int speaker, int mic) const;
+    void scheduleTransferFieldRebuild();
+    void cancelTransferFieldRebuild();
+    void postTransferFields(TransferFields fields, uint32_t generation);
+    static BandDecayTimes fitDecayTimes(const std::vector<Ray>& rays);
+    static float getWallAbsorption(const TraceScene& scene, int band);
+    static float getZoneTransmission(const TraceScene& scene, const Zone& zone, int band);
+    static PathRecords::EventFactors getEventFactors(const TraceScene& scene);
+    static float getSecondsPerBounce();
 
-    void performFrequencyAnalysis(float input);
-    void applyFrequencyEffects();
-    void handleWallReflection(int x, int y);
-    void handleZoneRefraction(int x, int y);
-    void processAudioForMicrophones(const float* input, int numSamples);
+    void calculateMicrophoneFrequencyResponse(int mic);
+    void applyResponse(int speaker, int mic, const MicFrequencyBands::BandValues& values);
+    void updateTailLength();
 
 
     // Ray tracing methods
-    Intersection traceRay(const Ray& ray) const;
+    Intersection traceRay(const TraceScene& scene, const Ray& ray) const;
     float calculateRayContribution(const Ray& ray, const juce::Point<float>& micPosition) const;
-    std::vector<Ray> generateReflectionRays(const Ray& ray, const Intersection& intersection) const;
-    void updateRayFrequencies(Ray& ray, const Intersection& intersection) const;
-    void calculateMicrophoneFrequencyResponses();
+    std::vector<Ray> generateReflectionRays(const TraceScene& scene, const Ray& ray, const Intersection& intersection) const;
+    void updateRayFrequencies(const TraceScene& scene, Ray& ray, const Intersection& intersection) const;
 
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RayTracer)
@@ -0,0 +1,164 @@
+#include "SharedTraceCache.h"
+#include "../DebugLogger.h"
+
+SharedTraceCache::~SharedTraceCache()
+{
+    // Let queued writes finish rather than dropping them
+    diskWrites.waitForAll();
+}
+
+SharedTraceCache::TraceResultPtr SharedTraceCache::find(const TraceKey& key)
+{
+    {
+        const std::lock_guard<std::mutex> guard(lock);
+
+        if (auto cached = findInMemory(key))
+            return cached;
+    }
+
+    // e.g. the scene of a session being reopened
+    if (auto stored = diskCache.load(key))
+    {
+        const std::lock_guard<std::mutex> guard(lock);
+
+        // Keep a copy someone loaded meanwhile, so there is only ever one
+        if (auto cached = findInMemory(key))
+            return cached;
+
+        insert(key, stored);
+        markPersisted(key);
+        return stored;
+    }
+
+    return nullptr;
+}
+
+SharedTraceCache::TraceResultPtr SharedTraceCache::findOrCompute(const TraceKey& key, const std::function<TraceResultPtr()>& compute)
+{
+    std::promise<TraceResultPtr> promise;
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+
+        if (auto cached = findInMemory(key))
+            return cached;
+
+        if (const auto pending = inFlight.find(key); pending != inFlight.end())
+        {
+            auto future = pending->second;
+            guard.unlock();
+
+            RIPPLE_LOG(Tracer, Debug, "Waiting for a trace of this scene already in progress");
+            return future.get();
+        }
+
+        inFlight.emplace(key, promise.get_future().share());
+    }
+
+    TraceResultPtr result;
+    bool loaded = false;
+
+    // Traces are written by persist() once their scene has settled
+    try
+    {
+        result = diskCache.load(key);
+        loaded = result != nullptr;
+
+        if (result == nullptr)
+            result = compute();
+    }
+    catch (...)
+    {
+        {
+            const std::lock_guard<std::mutex> guard(lock);
+            inFlight.erase(key);
+        }
+
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard(lock);
+
+        if (result != nullptr)
+            insert(key, result);
+
+        if (loaded)
+            markPersisted(key);
+
+        inFlight.erase(key);
+    }
+
+    promise.set_value(result);
+    return result;
+}
+
+bool SharedTraceCache::persist(const TraceKey& key)
+{
+    const std::lock_guard<std::mutex> guard(lock);
+
+    if (persisted.count(key) != 0)
+        return true;
+
+    auto result = findInMemory(key);
+    if (result == nullptr)
+        return false;
+
+    markPersisted(key);
+
+    // File I/O stays off the tracing and message threads
+    diskWrites.submit([this, key, result = std::move(result)]
+    {
+        diskCache.store(key, *result);
+    });
+
+    return true;
+}
+
+void SharedTraceCache::markPersisted(const TraceKey& key)
+{
+    if (persisted.size() >= static_cast<size_t>(TraceDiskCache::MAX_FILES))
+        persisted.clear();
+
+    persisted.insert(key);
+}
+
+SharedTraceCache::TraceResultPtr SharedTraceCache::findInMemory(const TraceKey& key)
+{
+    if (const auto* cached = recent.find(key))
+    {
+        RIPPLE_LOG(Tracer, Debug, "Reusing cached trace of this scene");
+        return *cached;
+    }
+
+    // Evicted from the recent entries, but maybe still published by an instance
+    if (const auto found = live.find(key); found != live.end())
+    {
+        if (auto result = found->second.lock())
+        {
+            RIPPLE_LOG(Tracer, Debug, "Sharing another instance's trace of this scene");
+            recent.insert(key, result);
+            return result;
+        }
+
+        live.erase(found);
+    }
+
+    return nullptr;
+}
+
+void SharedTraceCache::insert(const TraceKey& key, const TraceResultPtr& result)
+{
+    recent.insert(key, result);
+    live[key] = result;
+
+    // Forget results nobody holds any more
+    for (auto entry = live.begin(); entry != live.end();)
+    {
+        if (entry->second.expired())
+            entry = live.erase(entry);
+        else
+            ++entry;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include "RayTracer.h"
+#include "TraceDiskCache.h"
+#include "../Utils/LruCache.h"
+#include "../Utils/WorkerPool.h"
+
+/**
+ * Process-wide store of immutable trace results, shared by every plugin
+ * instance through a juce::SharedResourcePointer.
+ *
+ * Results are reference counted. The most recently used ones are kept
+ * alive; beyond that a result is only remembered weakly, so it exists once
+ * for as long as any instance has it published, however many instances
+ * share the scene. A request for a scene that another caller is already
+ * tracing waits for that trace instead of starting its own. Full traces of
+ * settled scenes are also persisted on disk (see TraceDiskCache).
+ *
+ * All methods are safe to call from any thread.
+ */
+class SharedTraceCache
+{
+public:
+    using TraceKey = RayTracer::TraceKey;
+    using TraceKeyHash = RayTracer::TraceKeyHash;
+    using TraceResultPtr = RayTracer::TraceResultPtr;
+
+    static constexpr size_t RECENT_ENTRIES = 32;
+
+    SharedTraceCache() = default;
+    ~SharedTraceCache();
+
+    /** The result for this key from memory or disk, or nullptr. Never waits for a trace in progress. */
+    TraceResultPtr find(const TraceKey& key);
+
+    /**
+     * The result for this key, computing it if nobody has. Concurrent calls
+     * for the same key run compute once and all receive its result.
+     */
+    TraceResultPtr findOrCompute(const TraceKey& key, const std::function<TraceResultPtr()>& compute);
+
+    /**
+     * Write the result for this key to disk on a background worker, unless it
+     * is there already. Only settled scenes are worth keeping, not every stage
+     * of a drag. Returns false if there is no such result in memory yet.
+     */
+    bool persist(const TraceKey& key);
+
+private:
+    // All require the lock
+    TraceResultPtr findInMemory(const TraceKey& key);
+    void insert(const TraceKey& key, const TraceResultPtr& result);
+    void markPersisted(const TraceKey& key);
+
+    std::mutex lock;
+    LruCache<TraceKey, TraceResultPtr, TraceKeyHash> recent { RECENT_ENTRIES };
+    std::unordered_map<TraceKey, std::weak_ptr<const RayTracer::TraceResult>, TraceKeyHash> live;
+    std::unordered_map<TraceKey, std::shared_future<TraceResultPtr>, TraceKeyHash> inFlight;
+
+    TraceDiskCache diskCache;
+
+    // Keys on disk or being written; forgotten in bulk, as a second write is harmless
+    std::unordered_set<TraceKey, TraceKeyHash> persisted;
+    WorkerPool::JobGroup diskWrites { WorkerPool::Priority::background };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedTraceCache)
+};
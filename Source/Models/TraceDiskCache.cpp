@@ -0,0 +1,394 @@
+#include "TraceDiskCache.h"
+#include "../DebugLogger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t FILE_MAGIC = 0x43545052;    // "RPTC"
+    constexpr uint32_t FLAG_TRANSFER_FIELD = 1u << 0;
+    constexpr uint32_t FLAG_MIC_EVALUATED = 1u << 1;     // one bit per mic from here
+
+    constexpr int NUM_BANDS = MicFrequencyBands::NUM_FREQUENCY_BANDS;
+
+    /** Bounds-checked reads of plain values from a file's contents. */
+    struct Reader
+    {
+        const char* data;
+        size_t size;
+        size_t position = 0;
+
+        template <typename T>
+        bool read(T& value)
+        {
+            return readArray(&value, 1);
+        }
+
+        template <typename T>
+        bool readArray(T* values, size_t count)
+        {
+            const auto numBytes = count * sizeof(T);
+            if (numBytes > size - position)
+                return false;
+
+            std::memcpy(values, data + position, numBytes);
+            position += numBytes;
+            return true;
+        }
+
+        bool readPoint(juce::Point<float>& point)
+        {
+            return read(point.x) && read(point.y);
+        }
+    };
+
+    template <typename T>
+    void write(juce::MemoryOutputStream& stream, const T& value)
+    {
+        stream.write(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void writeArray(juce::MemoryOutputStream& stream, const T* values, size_t count)
+    {
+        stream.write(values, count * sizeof(T));
+    }
+
+    void writePoint(juce::MemoryOutputStream& stream, juce::Point<float> point)
+    {
+        write(stream, point.x);
+        write(stream, point.y);
+    }
+
+    bool readScene(Reader& reader, uint32_t numSpeakers, uint32_t numZones, TraceScene& scene)
+    {
+        scene.speakers.resize(numSpeakers);
+        for (auto& speaker : scene.speakers)
+        {
+            if (!reader.readPoint(speaker))
+                return false;
+        }
+
+        for (auto& mic : scene.microphones)
+        {
+            if (!reader.readPoint(mic))
+                return false;
+        }
+
+        if (!reader.read(scene.defaultDensity) || !reader.read(scene.wallReflectivity) || !reader.read(scene.wallDamping))
+            return false;
+
+        scene.zones.resize(numZones);
+        for (auto& zone : scene.zones)
+        {
+            if (!reader.read(zone.x) || !reader.read(zone.y) || !reader.read(zone.width)
+                || !reader.read(zone.height) || !reader.read(zone.density))
+                return false;
+        }
+
+        return true;
+    }
+
+    void writeScene(juce::MemoryOutputStream& stream, const TraceScene& scene)
+    {
+        for (const auto& speaker : scene.speakers)
+            writePoint(stream, speaker);
+
+        for (const auto& mic : scene.microphones)
+            writePoint(stream, mic);
+
+        write(stream, scene.defaultDensity);
+        write(stream, scene.wallReflectivity);
+        write(stream, scene.wallDamping);
+
+        for (const auto& zone : scene.zones)
+        {
+            write(stream, zone.x);
+            write(stream, zone.y);
+            write(stream, zone.width);
+            write(stream, zone.height);
+            write(stream, zone.density);
+        }
+    }
+}
+
+TraceDiskCache::TraceDiskCache(juce::File directoryToUse)
+    : directory(std::move(directoryToUse))
+{
+}
+
+juce::File TraceDiskCache::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("Rippleator")
+               .getChildFile("TraceCache");
+}
+
+juce::File TraceDiskCache::getFileFor(const RayTracer::TraceKey& key) const
+{
+    const auto hash = static_cast<juce::int64>(RayTracer::TraceKeyHash()(key));
+    return directory.getChildFile(juce::String::toHexString(hash) + ".rtc");
+}
+
+RayTracer::TraceResultPtr TraceDiskCache::load(const RayTracer::TraceKey& key) const
+{
+    const auto file = getFileFor(key);
+    if (!file.existsAsFile())
+        return nullptr;
+
+    juce::MemoryBlock contents;
+    if (!file.loadFileAsData(contents))
+        return nullptr;
+
+    Reader reader { static_cast<const char*>(contents.getData()), contents.getSize() };
+
+    uint32_t magic = 0, version = 0, flags = 0, numRays = 0, numZones = 0, numSpeakers = 0;
+    uint64_t hash = 0;
+    int32_t maxReflections = 0;
+
+    if (!reader.read(magic) || !reader.read(version) || !reader.read(hash) || !reader.read(maxReflections)
+        || !reader.read(flags) || !reader.read(numRays) || !reader.read(numZones) || !reader.read(numSpeakers))
+        return nullptr;
+
+    if (magic != FILE_MAGIC || version != FORMAT_VERSION || hash != RayTracer::TraceKeyHash()(key))
+        return nullptr;
+
+    // Counts from a damaged file must not drive allocations past its size
+    if (numRays > reader.size / sizeof(float) || numZones > reader.size / sizeof(float)
+        || numSpeakers == 0 || numSpeakers > static_cast<uint32_t>(TraceScene::MAX_SPEAKERS))
+        return nullptr;
+
+    // The name is only a hash: the stored scene must match exactly
+    TraceScene scene;
+    if (!readScene(reader, numSpeakers, numZones, scene) || !scene.hasSameInputs(key.scene)
+        || maxReflections != key.maxReflections || ((flags & FLAG_TRANSFER_FIELD) != 0) != key.withTransferField)
+        return nullptr;
+
+    auto result = std::make_shared<RayTracer::TraceResult>();
+    result->maxReflections = maxReflections;
+
+    if (!reader.readArray(result->decayTimes.data(), result->decayTimes.size()))
+        return nullptr;
+
+    result->speakers.resize(numSpeakers);
+    size_t firstRay = 0;
+
+    for (auto& speaker : result->speakers)
+    {
+        uint32_t numSpeakerRays = 0;
+        if (!reader.read(numSpeakerRays) || numSpeakerRays > numRays - firstRay)
+            return nullptr;
+
+        speaker.firstRay = firstRay;
+        speaker.numRays = numSpeakerRays;
+        firstRay += numSpeakerRays;
+
+        for (int mic = 0; mic < 3; ++mic)
+        {
+            if ((flags & (FLAG_MIC_EVALUATED << mic)) == 0)
+                continue;
+
+            auto& weights = speaker.micWeights[mic];
+            weights.rays.resize(numSpeakerRays);
+
+            if (!reader.readArray(speaker.micValues[mic].data(), speaker.micValues[mic].size())
+                || !reader.readPoint(weights.position) || !reader.read(weights.direct)
+                || !reader.readArray(weights.rays.data(), weights.rays.size()))
+                return nullptr;
+
+            speaker.micEvaluated[mic] = true;
+        }
+    }
+
+    if (firstRay != numRays)
+        return nullptr;
+
+    result->rays.reserve(numRays);
+    for (uint32_t i = 0; i < numRays; ++i)
+    {
+        juce::Point<float> origin, direction;
+        float intensity = 0.0f, distance = 0.0f;
+        int32_t bounceCount = 0;
+        MicFrequencyBands::BandValues bands {};
+
+        if (!reader.readPoint(origin) || !reader.readPoint(direction) || !reader.read(intensity)
+            || !reader.read(distance) || !reader.read(bounceCount) || !reader.readArray(bands.data(), bands.size()))
+            return nullptr;
+
+        Ray ray(origin, direction);
+        ray.intensity = intensity;
+        ray.distance = distance;
+        ray.bounceCount = bounceCount;
+        for (int band = 0; band < NUM_BANDS; ++band)
+            ray.frequencyBands.bands[band].value = bands[band];
+
+        result->rays.push_back(ray);
+    }
+
+    std::vector<int32_t> parents(numRays);
+    std::vector<int16_t> events(numRays);
+    if (!reader.readArray(parents.data(), parents.size()) || !reader.readArray(events.data(), events.size()))
+        return nullptr;
+
+    auto paths = std::make_shared<PathRecords>();
+    paths->reserve(numRays);
+    for (uint32_t i = 0; i < numRays; ++i)
+    {
+        if (parents[i] >= static_cast<int32_t>(i))
+            return nullptr;
+
+        if (parents[i] < 0)
+            paths->addPrimaryRay();
+        else
+            paths->addChildRay(parents[i], events[i]);
+    }
+    paths->finalise(static_cast<int>(numZones));
+    result->paths = std::move(paths);
+
+    if ((flags & FLAG_TRANSFER_FIELD) != 0)
+    {
+        for (auto& speaker : result->speakers)
+        {
+            uint32_t numValues = 0;
+            if (!reader.read(numValues) || numValues > reader.size - reader.position)
+                return nullptr;
+
+            std::vector<uint16_t> storage(numValues);
+            auto field = std::make_shared<TransferField>();
+            if (!reader.readArray(storage.data(), storage.size()) || !field->restore(storage.data(), storage.size()))
+                return nullptr;
+
+            speaker.transferField = std::move(field);
+        }
+    }
+
+    if (reader.position != reader.size)
+        return nullptr;
+
+    // Mark as recently used, so it survives trimming
+    file.setLastModificationTime(juce::Time::getCurrentTime());
+
+    RIPPLE_LOG(Tracer, Debug, "Loaded cached trace {} ({} rays)", file.getFileName().toRawUTF8(), static_cast<int>(numRays));
+    return result;
+}
+
+void TraceDiskCache::store(const RayTracer::TraceKey& key, const RayTracer::TraceResult& result) const
+{
+    // Only full traces with path records are worth keeping
+    if (result.paths == nullptr || result.paths->getNumRays() != result.rays.size())
+        return;
+
+    if (result.speakers.empty() || result.speakers.size() != key.scene.speakers.size())
+        return;
+
+    const bool withTransferField = key.withTransferField;
+    for (const auto& speaker : result.speakers)
+    {
+        if (withTransferField && speaker.transferField == nullptr)
+            return;
+    }
+
+    juce::MemoryOutputStream stream;
+
+    // Every speaker of a result covers the same microphones
+    uint32_t flags = withTransferField ? FLAG_TRANSFER_FIELD : 0u;
+    for (int mic = 0; mic < 3; ++mic)
+    {
+        if (result.speakers.front().micEvaluated[mic])
+            flags |= FLAG_MIC_EVALUATED << mic;
+    }
+
+    const auto numRays = static_cast<uint32_t>(result.rays.size());
+
+    write(stream, FILE_MAGIC);
+    write(stream, FORMAT_VERSION);
+    write(stream, static_cast<uint64_t>(RayTracer::TraceKeyHash()(key)));
+    write(stream, static_cast<int32_t>(key.maxReflections));
+    write(stream, flags);
+    write(stream, numRays);
+    write(stream, static_cast<uint32_t>(key.scene.zones.size()));
+    write(stream, static_cast<uint32_t>(key.scene.speakers.size()));
+    writeScene(stream, key.scene);
+
+    writeArray(stream, result.decayTimes.data(), result.decayTimes.size());
+
+    for (const auto& speaker : result.speakers)
+    {
+        write(stream, static_cast<uint32_t>(speaker.numRays));
+
+        for (int mic = 0; mic < 3; ++mic)
+        {
+            if ((flags & (FLAG_MIC_EVALUATED << mic)) == 0)
+                continue;
+
+            const auto& weights = speaker.micWeights[mic];
+            jassert(weights.rays.size() == speaker.numRays);
+
+            writeArray(stream, speaker.micValues[mic].data(), speaker.micValues[mic].size());
+            writePoint(stream, weights.position);
+            write(stream, weights.direct);
+            writeArray(stream, weights.rays.data(), weights.rays.size());
+        }
+    }
+
+    for (const auto& ray : result.rays)
+    {
+        writePoint(stream, ray.origin);
+        writePoint(stream, ray.direction);
+        write(stream, ray.intensity);
+        write(stream, ray.distance);
+        write(stream, static_cast<int32_t>(ray.bounceCount));
+        for (int band = 0; band < NUM_BANDS; ++band)
+            write(stream, ray.frequencyBands.bands[band].value);
+    }
+
+    writeArray(stream, result.paths->getParents().data(), result.paths->getParents().size());
+    writeArray(stream, result.paths->getEvents().data(), result.paths->getEvents().size());
+
+    if (withTransferField)
+    {
+        for (const auto& speaker : result.speakers)
+        {
+            const auto& storage = speaker.transferField->getStorage();
+            write(stream, static_cast<uint32_t>(storage.size()));
+            writeArray(stream, storage.data(), storage.size());
+        }
+    }
+
+    if (!directory.createDirectory())
+        return;
+
+    const auto file = getFileFor(key);
+    juce::TemporaryFile temporary(file);
+
+    {
+        auto output = temporary.getFile().createOutputStream();
+        if (output == nullptr)
+            return;
+
+        output->write(stream.getData(), stream.getDataSize());
+        output->flush();
+    }
+
+    if (!temporary.overwriteTargetFileWithTemporary())
+        return;
+
+    RIPPLE_LOG(Tracer, Debug, "Stored trace {} ({} bytes)", file.getFileName().toRawUTF8(), static_cast<int>(stream.getDataSize()));
+    removeOldestFiles();
+}
+
+void TraceDiskCache::removeOldestFiles() const
+{
+    auto files = directory.findChildFiles(juce::File::findFiles, false, "*.rtc");
+    if (static_cast<int>(files.size()) <= MAX_FILES)
+        return;
+
+    std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+    {
+        return a.getLastModificationTime() < b.getLastModificationTime();
+    });
+
+    const auto numToRemove = static_cast<int>(files.size()) - MAX_FILES;
+    for (int i = 0; i < numToRemove; ++i)
+        files[i].deleteFile();
+}
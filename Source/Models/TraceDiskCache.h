@@ -0,0 +1,43 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "RayTracer.h"
+
+/**
+ * Persistent store of full traces, one file per scene, so that reopening a
+ * session finds its chambers already traced.
+ *
+ * Files hold each speaker's per-mic responses, weights and transfer field
+ * (if one was built), the rays and their path records and the decay times, in a
+ * flat versioned binary layout. Everything is parsed into a TraceResult, so a
+ * file is read in one go and verified against the full scene: a stale,
+ * truncated or foreign file is a miss, never a wrong result. Writes go
+ * through a temporary file, so concurrent plugin instances only ever see
+ * complete files. Only settled scenes are stored (see SharedTraceCache).
+ *
+ * All methods are safe to call from any thread.
+ */
+class TraceDiskCache
+{
+public:
+    static constexpr uint32_t FORMAT_VERSION = 2;
+    static constexpr int MAX_FILES = 256;
+
+    explicit TraceDiskCache(juce::File directory = getDefaultDirectory());
+
+    static juce::File getDefaultDirectory();
+
+    /** The stored result for this key, or nullptr if there is none or it is stale. */
+    RayTracer::TraceResultPtr load(const RayTracer::TraceKey& key) const;
+
+    /** Write a result, replacing any previous one, and trim the oldest files. */
+    void store(const RayTracer::TraceKey& key, const RayTracer::TraceResult& result) const;
+
+private:
+    juce::File getFileFor(const RayTracer::TraceKey& key) const;
+    void removeOldestFiles() const;
+
+    juce::File directory;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceDiskCache)
+};
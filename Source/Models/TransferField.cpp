@@ -0,0 +1,43 @@
+#include "TransferField.h"
+#include <cstring>
+
+bool TransferField::restore(const uint16_t* storage, size_t numValues)
+{
+    valid = false;
+
+    if (storage == nullptr || numValues != values.size())
+        return false;
+
+    std::memcpy(values.data(), storage, numValues * sizeof(uint16_t));
+    valid = true;
+    return true;
+}
+
+TransferField::BandValues TransferField::lookup(juce::Point<float> position) const noexcept
+{
+    constexpr float maxIndex = static_cast<float>(GRID_SIZE - 1);
+
+    const float gridX = juce::jlimit(0.0f, maxIndex, position.x * maxIndex);
+    const float gridY = juce::jlimit(0.0f, maxIndex, position.y * maxIndex);
+
+    const int x0 = juce::jmin(static_cast<int>(gridX), GRID_SIZE - 2);
+    const int y0 = juce::jmin(static_cast<int>(gridY), GRID_SIZE - 2);
+    const float fx = gridX - static_cast<float>(x0);
+    const float fy = gridY - static_cast<float>(y0);
+
+    const auto* c00 = values.data() + getCellIndex(x0, y0);
+    const auto* c10 = values.data() + getCellIndex(x0 + 1, y0);
+    const auto* c01 = values.data() + getCellIndex(x0, y0 + 1);
+    const auto* c11 = values.data() + getCellIndex(x0 + 1, y0 + 1);
+
+    BandValues result {};
+
+    for (int band = 0; band < NUM_BANDS; ++band)
+    {
+        const float top = juce::jmap(fx, Float16::toFloat(c00[band]), Float16::toFloat(c10[band]));
+        const float bottom = juce::jmap(fx, Float16::toFloat(c01[band]), Float16::toFloat(c11[band]));
+        result[static_cast<size_t>(band)] = juce::jmap(fy, top, bottom);
+    }
+
+    return result;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "MicFrequencyBands.h"
+#include "../Utils/Float16.h"
+
+/**
+ * Per-band microphone responses precomputed on a regular grid of candidate
+ * mic positions for one speaker/zone layout.
+ *
+ * Values are stored as float16 and bilinearly interpolated on lookup, so
+ * moving a microphone costs a handful of loads instead of a retrace.
+ */
+class TransferField
+{
+public:
+    static constexpr int GRID_SIZE = 33;    // Grid points per side, spanning the unit chamber
+    static constexpr int NUM_BANDS = MicFrequencyBands::NUM_FREQUENCY_BANDS;
+
+    using BandValues = MicFrequencyBands::BandValues;
+
+    TransferField() : values(static_cast<size_t>(GRID_SIZE * GRID_SIZE * NUM_BANDS), 0) {}
+
+    /**
+     * Evaluate every grid point.
+     * @param evaluate Called as evaluate(juce::Point<float>) -> BandValues
+     */
+    template <typename Evaluator>
+    void build(Evaluator&& evaluate)
+    {
+        for (int y = 0; y < GRID_SIZE; ++y)
+        {
+            for (int x = 0; x < GRID_SIZE; ++x)
+            {
+                const BandValues bands = evaluate(getGridPosition(x, y));
+                auto* cell = values.data() + getCellIndex(x, y);
+
+                for (int band = 0; band < NUM_BANDS; ++band)
+                    cell[band] = Float16::fromFloat(bands[static_cast<size_t>(band)]);
+            }
+        }
+
+        valid = true;
+    }
+
+    /** Forget the field, e.g. because the speaker or zones changed. */
+    void invalidate() noexcept { valid = false; }
+    bool isValid() const noexcept { return valid; }
+
+    /** Raw float16 grid values, for serialisation. */
+    const std::vector<uint16_t>& getStorage() const noexcept { return values; }
+
+    /** Restore a grid from getStorage(); false (and left invalid) if the size doesn't match. */
+    bool restore(const uint16_t* storage, size_t numValues);
+
+    /** Interpolated band values at a position in normalised chamber coordinates. */
+    BandValues lookup(juce::Point<float> position) const noexcept;
+
+    static juce::Point<float> getGridPosition(int x, int y) noexcept
+    {
+        constexpr float step = 1.0f / static_cast<float>(GRID_SIZE - 1);
+        return { static_cast<float>(x) * step, static_cast<float>(y) * step };
+    }
+
+private:
+    static size_t getCellIndex(int x, int y) noexcept
+    {
+        return static_cast<size_t>((y * GRID_SIZE + x) * NUM_BANDS);
+    }
+
+    std::vector<uint16_t> values;
+    bool valid = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TransferField)
+};
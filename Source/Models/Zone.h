@@ -14,4 +14,12 @@ struct Zone
     float width;      // Width (0-1)
     float height;     // Height (0-1)
     float density;    // Density of the medium in this zone
+
+    bool operator==(const Zone& other) const
+    {
+        return x == other.x && y == other.y && width == other.width
+               && height == other.height && density == other.density;
+    }
+
+    bool operator!=(const Zone& other) const { return !(*this == other); }
 };
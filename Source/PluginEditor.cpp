@@ -5,7 +5,7 @@ RippleatorAudioProcessorEditor::RippleatorAudioProcessorEditor(RippleatorAudioPr
       tabbedComponent(juce::TabbedButtonBar::TabsAtTop),
       chamberVisualizer(p.getChamber()),
       zoneManager(p.getChamber()),
-      visualizationsTab(p.getChamber()),
+      visualizationsTab(p, p.getChamber()),
       tabNameResetCounter(0)
 {
     // Set up title
@@ -30,6 +30,10 @@ RippleatorAudioProcessorEditor::RippleatorAudioProcessorEditor(RippleatorAudioPr
     };
     addAndMakeVisible(bypassButton);
     
+    // Filled in by the timer once the processor has more than one chamber
+    channelSelector.onChange = [this] { showArrayChamber(channelSelector.getSelectedItemIndex()); };
+    addChildComponent(channelSelector);
+    
     // Set up chamber parameter controls
     densityLabel.setText("Medium Density", juce::dontSendNotification);
     densityLabel.setFont(juce::Font(14.0f));
@@ -77,6 +81,12 @@ RippleatorAudioProcessorEditor::RippleatorAudioProcessorEditor(RippleatorAudioPr
     outputLevelMeter.setRange(-20.0, 0.0, 0.1);
     addAndMakeVisible(outputLevelMeter);
     
+    // Loudness is only measured while someone is looking at it
+    loudnessLabel.setFont(juce::Font(14.0f));
+    loudnessLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(loudnessLabel);
+    audioProcessor.setLoudnessMeteringEnabled(true);
+    
     // Create parameter attachments
     auto& parameters = audioProcessor.getParameters();
     densityAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
@@ -142,6 +152,7 @@ RippleatorAudioProcessorEditor::RippleatorAudioProcessorEditor(RippleatorAudioPr
 RippleatorAudioProcessorEditor::~RippleatorAudioProcessorEditor()
 {
     stopTimer();
+    audioProcessor.setLoudnessMeteringEnabled(false);
     densityAttachment.reset();
     reflectivityAttachment.reset();
     dampingAttachment.reset();
@@ -167,8 +178,10 @@ void RippleatorAudioProcessorEditor::resized()
     // Title at the top
     titleLabel.setBounds(area.removeFromTop(30));
     
-    // Add bypass button
-    bypassButton.setBounds(area.removeFromTop(30).withSizeKeepingCentre(150, 24));
+    // Add bypass button, with the channel selector beside it
+    auto bypassRow = area.removeFromTop(30);
+    channelSelector.setBounds(bypassRow.removeFromRight(120).withSizeKeepingCentre(120, 24));
+    bypassButton.setBounds(bypassRow.withSizeKeepingCentre(150, 24));
     
     area.removeFromTop(10); // Add some spacing
     
@@ -200,6 +213,7 @@ void RippleatorAudioProcessorEditor::resized()
     auto row3 = controlsArea.removeFromTop(30);
     dampingLabel.setBounds(row3.removeFromLeft(120));
     dampingSlider.setBounds(row3.removeFromLeft(200));
+    loudnessLabel.setBounds(row3.removeFromRight(200));
     
     // Add spacing
     controlsArea.removeFromTop(5);
@@ -251,10 +265,37 @@ void RippleatorAudioProcessorEditor::timerCallback()
         float level = audioProcessor.getMicrophoneLevel(i);
         micControls[i].levelMeter.setLevel(level);
     }
+    inputLevelMeter.setLevel(audioProcessor.getInputLevel());
+    outputLevelMeter.setLevel(audioProcessor.getOutputLevel());
+    
+    float loudness = audioProcessor.getOutputLoudness();
+    loudnessLabel.setText(loudness <= LoudnessMeter::MIN_LUFS ? juce::String("Short-term: -inf LUFS")
+                                                              : "Short-term: " + juce::String(loudness, 1) + " LUFS",
+                          juce::dontSendNotification);
+    
+    // Offer a chamber per channel while the layout has them
+    const int numArrayChambers = audioProcessor.getNumArrayChambers();
+    if (numArrayChambers != channelSelector.getNumItems())
+    {
+        channelSelector.clear(juce::dontSendNotification);
+        for (int channel = 0; channel < numArrayChambers; ++channel)
+            channelSelector.addItem("Channel " + juce::String(channel + 1), channel + 1);
+        
+        channelSelector.setVisible(numArrayChambers > 1);
+        showArrayChamber(shownChamber < numArrayChambers ? shownChamber : 0);
+    }
     
     // Update chamber visualizer
     chamberVisualizer.repaint();
     
+    // Rebuild the zone controls if the host restored a different scene
+    const auto sceneRestoreCount = audioProcessor.getArrayChamber(shownChamber).getSceneRestoreCount();
+    if (sceneRestoreCount != lastSceneRestoreCount)
+    {
+        lastSceneRestoreCount = sceneRestoreCount;
+        zoneManager.syncWithChamber();
+    }
+    
     // Update bypass button state (in case it was changed via keyboard shortcut)
     bypassButton.setToggleState(audioProcessor.isBypassProcessingEnabled(), juce::dontSendNotification);
     
@@ -272,6 +313,20 @@ void RippleatorAudioProcessorEditor::timerCallback()
     }
 }
 
+void RippleatorAudioProcessorEditor::showArrayChamber(int channel)
+{
+    channelSelector.setSelectedItemIndex(channel, juce::dontSendNotification);
+    
+    if (channel == shownChamber)
+        return;
+    
+    shownChamber = channel;
+    auto& chamber = audioProcessor.getArrayChamber(channel);
+    chamberVisualizer.setChamber(chamber);
+    zoneManager.setChamber(chamber);
+    lastSceneRestoreCount = chamber.getSceneRestoreCount();
+}
+
 bool RippleatorAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
 {
     // Toggle bypass processing with 'B' key
@@ -291,5 +346,23 @@ bool RippleatorAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
         return true;
     }
     
+    // Geometry undo with Cmd/Ctrl+Z, redo with Cmd/Ctrl+Shift+Z or Cmd/Ctrl+Y
+    if (key.getModifiers().isCommandDown())
+    {
+        auto& chamber = audioProcessor.getArrayChamber(shownChamber);
+        const bool redo = key.getKeyCode() == 'Y' || (key.getKeyCode() == 'Z' && key.getModifiers().isShiftDown());
+        
+        if (key.getKeyCode() == 'Z' || key.getKeyCode() == 'Y')
+        {
+            if (redo ? chamber.redoGeometry() : chamber.undoGeometry())
+            {
+                zoneManager.syncWithChamber();
+                chamberVisualizer.repaint();
+            }
+            
+            return true;
+        }
+    }
+    
     return juce::Component::keyPressed(key);
 }
@@ -25,6 +25,9 @@ public:
 private:
     RippleatorAudioProcessor& audioProcessor;
     
+    // Point the chamber and zone tabs at one channel's chamber
+    void showArrayChamber(int channel);
+    
     // Tabbed component for different views
     juce::TabbedComponent tabbedComponent;
     
@@ -39,9 +42,17 @@ private:
     // Bypass processing button
     juce::ToggleButton bypassButton;
     
+    // Which channel's chamber the chamber and zone tabs edit; only shown
+    // for layouts of more than two channels
+    juce::ComboBox channelSelector;
+    int shownChamber = 0;
+    
     // For tab name reset
     int tabNameResetCounter;
     
+    // Scene restores already reflected in the zone controls
+    uint32_t lastSceneRestoreCount = 0;
+    
     // Microphone controls
     struct MicControls
     {
@@ -78,6 +89,7 @@ private:
     // Level meters
     LevelMeter inputLevelMeter;
     LevelMeter outputLevelMeter;
+    juce::Label loudnessLabel;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RippleatorAudioProcessorEditor)
 };
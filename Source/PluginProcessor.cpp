@@ -1,12 +1,15 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "DebugLogger.h"
+#include "Utils/AllocationGuard.h"
 
 // Define M_PI if not already defined
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+static_assert(ChamberFilterBank::NUM_MICROPHONES == Chamber::NUM_MICROPHONES, "The filter bank runs every chamber's mics");
+
 //==============================================================================
 juce::AudioProcessorValueTreeState::ParameterLayout RippleatorAudioProcessor::createParameterLayout()
 {
@@ -84,6 +87,20 @@ juce::AudioProcessorValueTreeState::ParameterLayout RippleatorAudioProcessor::cr
         "Mic 3 Mute",
         false));
     
+    // Changes the latency, so it takes effect the next time playback is prepared
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        "pipelined",
+        "Pipelined Processing",
+        false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)));
+    
+    // Filters the mics on shared helper threads; takes effect the next time playback is prepared
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        "parallelMics",
+        "Parallel Microphone Processing",
+        false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)));
+    
     return { params.begin(), params.end() };
 }
 
@@ -93,63 +110,105 @@ RippleatorAudioProcessor::RippleatorAudioProcessor()
                      .withInput("Input", juce::AudioChannelSet::stereo(), true)
                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       parameters(*this, nullptr, juce::Identifier("Rippleator"), createParameterLayout()),
-      levelDecayRate(0.9f),
-      phase440Hz(0.0f),
-      phase880Hz(0.0f),
-      phase1760Hz(0.0f),
-      bypassProcessing(false),
-      micLevels{0.0f, 0.0f, 0.0f},
-      micLevelSmoothed{0.0f, 0.0f, 0.0f},
       microphoneEnabled{true, true, true}
 {
     // Initialize debug logger
     DebugLogger::initialize();
-    DebugLogger::logWithCategory("INIT", "RippleatorAudioProcessor constructor start");
+    RIPPLE_LOG(Init, Info, "RippleatorAudioProcessor constructor start");
+    
+    // Channel chambers are added from prepareToPlay while automation may be
+    // walking them, so the vector must never reallocate
+    channelChambers.reserve(static_cast<size_t>(ChamberFilterBank::MAX_CHAMBERS - 1));
+    
+    // Every scene edit below collapses into one evaluation after construction
+    Chamber::ScopedEdit sceneEdit(chamber);
+    
+    // Mic drags become lookups into a precomputed field
+    chamber.setTransferFieldEnabled(true);
     
     // Initialize chamber parameters
     try {
-        DebugLogger::logWithCategory("INIT", "Initializing chamber with sample rate: " + std::to_string(getSampleRate()));
-        chamber.initialize(0.0f, 0.5f);  // Speaker on left wall
-        DebugLogger::logWithCategory("INIT", "Chamber initialized successfully");
+        RIPPLE_LOG(Init, Info, "Initializing chamber with sample rate: {}", getSampleRate());
+        chamber.setSpeakerPosition(0.0f, 0.5f);  // Speaker on left wall
+        chamber.initialize();
+        RIPPLE_LOG(Init, Info, "Chamber initialized successfully");
     }
     catch (const std::exception& e) {
-        DebugLogger::logWithCategory("ERROR", "Exception during chamber initialization: " + std::string(e.what()));
+        RIPPLE_LOG(Init, Error, "Exception during chamber initialization: {}", e.what());
     }
     catch (...) {
-        DebugLogger::logWithCategory("ERROR", "Unknown exception during chamber initialization");
+        RIPPLE_LOG(Init, Error, "Unknown exception during chamber initialization");
     }
     
     // Set up parameter listeners
-    DebugLogger::logWithCategory("INIT", "Setting up parameter listeners");
+    RIPPLE_LOG(Init, Info, "Setting up parameter listeners");
     parameters.addParameterListener("mediumDensity", this);
     parameters.addParameterListener("wallReflectivity", this);
     parameters.addParameterListener("wallDamping", this);
     
+    // Cache parameter handles so the audio thread never looks them up by name
+    outputGainParameter = parameters.getRawParameterValue("outputGain");
+    for (int i = 0; i < Chamber::NUM_MICROPHONES; ++i)
+    {
+        juce::String prefix = "mic" + juce::String(i + 1);
+        micVolumeParameters[i] = parameters.getRawParameterValue(prefix + "Volume");
+        micSoloParameters[i] = parameters.getRawParameterValue(prefix + "Solo");
+        micMuteParameters[i] = parameters.getRawParameterValue(prefix + "Mute");
+        parameters.addParameterListener(prefix + "Solo", this);
+        parameters.addParameterListener(prefix + "Mute", this);
+    }
+    updateActiveMicrophones();
+    
     // Initialize microphone positions
-    DebugLogger::logWithCategory("INIT", "Setting microphone positions");
+    RIPPLE_LOG(Init, Info, "Setting microphone positions");
     chamber.setMicrophonePosition(0, 0.75f, 0.25f);  // Top right
     chamber.setMicrophonePosition(1, 0.75f, 0.5f);   // Middle right
     chamber.setMicrophonePosition(2, 0.75f, 0.75f);  // Bottom right
     
-    DebugLogger::logWithCategory("INIT", "RippleatorAudioProcessor constructor completed");
+    RIPPLE_LOG(Init, Info, "RippleatorAudioProcessor constructor completed");
 }
 
 RippleatorAudioProcessor::~RippleatorAudioProcessor()
 {
+    // The pipeline thread uses members destroyed before it
+    pipeline.release();
+    
     parameters.removeParameterListener("mediumDensity", this);
     parameters.removeParameterListener("wallReflectivity", this);
     parameters.removeParameterListener("wallDamping", this);
+    for (int i = 0; i < Chamber::NUM_MICROPHONES; ++i)
+    {
+        juce::String prefix = "mic" + juce::String(i + 1);
+        parameters.removeParameterListener(prefix + "Solo", this);
+        parameters.removeParameterListener(prefix + "Mute", this);
+    }
+
+    DebugLogger::shutdown();
 }
 
 void RippleatorAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
 {
     // Handle parameter changes
-    juce::Logger::writeToLog("Parameter changed: " + parameterID + " = " + juce::String(newValue));
+    RIPPLE_LOG(Audio, Debug, "Parameter changed: {} = {}", parameterID.toRawUTF8(), newValue);
     
     // Update chamber properties based on parameter changes
     if (parameterID == "mediumDensity")
     {
-        chamber.setDefaultMediumDensity(newValue);
+        forEachArrayChamber([newValue](Chamber& arrayChamber) { arrayChamber.setDefaultMediumDensity(newValue); });
+    }
+    else if (parameterID == "wallReflectivity")
+    {
+        forEachArrayChamber([newValue](Chamber& arrayChamber) { arrayChamber.setWallReflectivity(newValue); });
+    }
+    else if (parameterID == "wallDamping")
+    {
+        forEachArrayChamber([newValue](Chamber& arrayChamber) { arrayChamber.setWallDamping(newValue); });
+    }
+    else if (parameterID.endsWith("Solo") || parameterID.endsWith("Mute"))
+    {
+        // Automation may call this on the audio thread; the chambers only
+        // record the request and start mics from the message thread
+        updateActiveMicrophones();
     }
     
     // If we need to add zone-specific properties, we can use the Chamber's zone management methods:
@@ -178,7 +237,14 @@ bool RippleatorAudioProcessor::isMidiEffect() const
 
 double RippleatorAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // In array mode every channel rings for as long as its own chamber
+    double tailSeconds = chamber.getTailLengthSeconds();
+    const int numInUse = numChannelChambers.load(std::memory_order_acquire);
+    
+    for (int index = 0; index < numInUse; ++index)
+        tailSeconds = juce::jmax(tailSeconds, channelChambers[static_cast<size_t>(index)]->getTailLengthSeconds());
+    
+    return tailSeconds;
 }
 
 int RippleatorAudioProcessor::getNumPrograms()
@@ -206,216 +272,496 @@ void RippleatorAudioProcessor::changeProgramName(int index, const juce::String&
 
 void RippleatorAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    DebugLogger::logWithCategory("AUDIO", "prepareToPlay called with sampleRate: " + std::to_string(sampleRate) + 
-                            ", samplesPerBlock: " + std::to_string(samplesPerBlock));
+    RIPPLE_LOG(Audio, Debug, "prepareToPlay called with sampleRate: {}, samplesPerBlock: {}", sampleRate, samplesPerBlock);
+    
+    // The pipeline thread runs the whole chain, so stop it before anything
+    // it uses is reallocated; it is restarted once everything is in place
+    pipeline.release();
     
     try {
-        chamber.initialize(0.0f, 0.5f);
-        DebugLogger::logWithCategory("AUDIO", "Chamber reinitialized in prepareToPlay");
+        {
+            Chamber::ScopedEdit sceneEdit(chamber);
+            
+            chamber.setSampleRate(sampleRate);
+            chamber.initialize();
+            RIPPLE_LOG(Audio, Debug, "Chamber reinitialized in prepareToPlay");
+            
+            // Set the default medium density from the parameter
+            float mediumDensity = *parameters.getRawParameterValue("mediumDensity");
+            chamber.setDefaultMediumDensity(mediumDensity);
+            RIPPLE_LOG(Audio, Debug, "Medium density set to: {}", mediumDensity);
+            
+            chamber.setWallReflectivity(*parameters.getRawParameterValue("wallReflectivity"));
+            chamber.setWallDamping(*parameters.getRawParameterValue("wallDamping"));
+        }
         
-        // Set the default medium density from the parameter
-        float mediumDensity = *parameters.getRawParameterValue("mediumDensity");
-        chamber.setDefaultMediumDensity(mediumDensity);
-        DebugLogger::logWithCategory("AUDIO", "Medium density set to: " + std::to_string(mediumDensity));
+        // Audio is about to need the responses, so evaluate the scene now
+        chamber.evaluate();
+        
+        // Allocate everything processBlock needs up front. Everything after the
+        // FIFO works on fixed quanta, whatever block size the host uses.
+        constexpr int quantumSize = QuantumFifo::QUANTUM_SIZE;
+        const int numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+        quantumFifo.prepare(numChannels);
+        
+        // More than two channels: a chamber per channel, filtered side by side
+        prepareChannelChambers(numChannels, sampleRate);
+        chamberBank.prepare(sampleRate);
+        
+        micScratchBuffer.setSize(Chamber::NUM_MICROPHONES, quantumSize);
+        dryBuffer.setSize(juce::jmax(2, numChannels), quantumSize);
+        bankScratchBuffer.setSize(ChamberFilterBank::MAX_CHAMBERS, quantumSize);
+        laneInBank.fill(false);
+        bypassRamp.assign(static_cast<size_t>(quantumSize), 0.0f);
+        wetGain.reset(sampleRate, BYPASS_FADE_SECONDS);
+        wetGain.setCurrentAndTargetValue(bypassProcessing.load() ? 0.0f : 1.0f);
+        fullyBypassed = false;
+        chamber.prepare(quantumSize);
+        
+        // Only on request: the helpers cost a core's worth of wake-ups, and
+        // the chamber still only hands out quanta with enough filtering in them
+        chamber.setParallelProcessingEnabled(*parameters.getRawParameterValue("parallelMics") > 0.5f);
+        routingMatrix.prepare(sampleRate, quantumSize, Chamber::NUM_MICROPHONES, 2);
         
         // Reset level meters
-        for (int i = 0; i < 3; ++i)
+        for (auto& meter : inputMeters)
+        {
+            meter.prepare(sampleRate);
+        }
+        for (auto& meter : micMeters)
+        {
+            meter.prepare(sampleRate);
+        }
+        for (auto& meter : outputMeters)
         {
-            micLevels[i] = 0.0f;
-            micLevelSmoothed[i] = 0.0f;
+            meter.prepare(sampleRate);
         }
-        DebugLogger::logWithCategory("AUDIO", "Level meters reset");
+        outputLoudness.prepare(sampleRate);
+        RIPPLE_LOG(Audio, Debug, "Level meters reset");
+        
+        // Pipelined: the whole chain runs one host block behind, on its own thread
+        if (*parameters.getRawParameterValue("pipelined") > 0.5f)
+        {
+            pipeline.prepare(numChannels, samplesPerBlock, [this](const juce::dsp::AudioBlock<float>& block)
+            {
+                processThroughQuantumFifo(block, pipelineInputChannels.load(std::memory_order_relaxed));
+            });
+            RIPPLE_LOG(Audio, Debug, "Pipelined processing, {} samples of added latency", pipeline.getLatencySamples());
+        }
+        
+        setLatencySamples(quantumFifo.getLatencySamples() + (pipeline.isPrepared() ? pipeline.getLatencySamples() : 0));
     }
     catch (const std::exception& e) {
-        DebugLogger::logWithCategory("ERROR", "Exception in prepareToPlay: " + std::string(e.what()));
+        RIPPLE_LOG(Audio, Error, "Exception in prepareToPlay: {}", e.what());
     }
     catch (...) {
-        DebugLogger::logWithCategory("ERROR", "Unknown exception in prepareToPlay");
+        RIPPLE_LOG(Audio, Error, "Unknown exception in prepareToPlay");
+    }
+}
+
+void RippleatorAudioProcessor::prepareChannelChambers(int numChannels, double sampleRate)
+{
+    const int numNeeded = numChannels > 2 ? juce::jmin(numChannels, ChamberFilterBank::MAX_CHAMBERS) - 1 : 0;
+    
+    // New chambers start from their saved scene, or else as a copy of the first
+    juce::MemoryBlock firstScene;
+    {
+        juce::MemoryOutputStream stream(firstScene, false);
+        chamber.writeScene(stream);
+    }
+    
+    // Prepared before a saved scene is read, so the scene's responses fit and need no retrace
+    const auto prepareChamber = [this, sampleRate](Chamber& channelChamber)
+    {
+        Chamber::ScopedEdit sceneEdit(channelChamber);
+        channelChamber.setSampleRate(sampleRate);
+        channelChamber.initialize();
+        channelChamber.setDefaultMediumDensity(*parameters.getRawParameterValue("mediumDensity"));
+        channelChamber.setWallReflectivity(*parameters.getRawParameterValue("wallReflectivity"));
+        channelChamber.setWallDamping(*parameters.getRawParameterValue("wallDamping"));
+    };
+    
+    // Chambers the layout no longer uses are kept, scene and all, for the
+    // state, the next layout and any editor still showing them
+    for (int index = 0; index < juce::jmin(numNeeded, static_cast<int>(channelChambers.size())); ++index)
+        prepareChamber(*channelChambers[static_cast<size_t>(index)]);
+    
+    for (auto index = channelChambers.size(); static_cast<int>(index) < numNeeded; ++index)
+    {
+        auto channelChamber = std::make_unique<Chamber>();
+        Chamber::ScopedEdit sceneEdit(*channelChamber);
+        channelChamber->setTransferFieldEnabled(true);
+        channelChamber->setSpeakerPosition(0.0f, 0.5f);
+        prepareChamber(*channelChamber);
+        
+        const bool saved = index < pendingChannelScenes.size() && pendingChannelScenes[index].getSize() > 0;
+        juce::MemoryInputStream stream(saved ? pendingChannelScenes[index] : firstScene, false);
+        if (!channelChamber->readScene(stream))
+            RIPPLE_LOG(Audio, Warning, "Ignoring unreadable scene for channel chamber {}", static_cast<int>(index) + 1);
+        
+        jassert(channelChambers.size() < channelChambers.capacity());
+        channelChambers.push_back(std::move(channelChamber));
+    }
+    
+    // Chambers with several speakers are filtered by Chamber::process
+    for (int index = 0; index < numNeeded; ++index)
+    {
+        auto& channelChamber = *channelChambers[static_cast<size_t>(index)];
+        channelChamber.evaluate();
+        channelChamber.prepare(QuantumFifo::QUANTUM_SIZE);
     }
+    
+    numChannelChambers.store(numNeeded, std::memory_order_release);
+    updateActiveMicrophones();
+    
+    RIPPLE_LOG(Audio, Debug, "{} of {} channel chambers in use", numNeeded, static_cast<int>(channelChambers.size()));
 }
 
 void RippleatorAudioProcessor::releaseResources()
 {
+    pipeline.release();
 }
 
 bool RippleatorAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
-    // Only support mono input and stereo output
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo()
-        || layouts.getMainInputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    return true;
+    const auto input = layouts.getMainInputChannelSet();
+    const auto output = layouts.getMainOutputChannelSet();
+    
+    // Stereo in and out, mixed through the routing matrix
+    if (input == juce::AudioChannelSet::stereo() && output == juce::AudioChannelSet::stereo())
+        return true;
+    
+    // Or matching multichannel layouts (e.g. 5.1, 7.1), with a chamber per channel
+    const int numChannels = input.size();
+    return input == output && numChannels > 2 && numChannels <= ChamberFilterBank::MAX_CHAMBERS;
 }
 
 void RippleatorAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                           juce::MidiBuffer& midiMessages)
 {
+    // Nothing in the callback may touch the heap (checked in debug builds)
+    ScopedAllocationGuard allocationGuard;
+    
     static bool firstProcessBlock = true;
     if (firstProcessBlock) {
-        DebugLogger::logWithCategory("AUDIO", "First processBlock call");
+        RIPPLE_LOG(Audio, Trace, "First processBlock call");
         firstProcessBlock = false;
     }
     
     juce::ScopedNoDenormals noDenormals;
-    chamber.setSampleRate(getSampleRate());
     
     try {
         // Only log occasionally to avoid filling the log file
         static int processBlockCounter = 0;
         if (processBlockCounter++ % 100 == 0) {
-            DebugLogger::logWithCategory("AUDIO", "processBlock called (iteration " + std::to_string(processBlockCounter) + ")");
+            RIPPLE_LOG(Audio, Trace, "processBlock called (iteration {})", processBlockCounter);
         }
         
-        auto numSamples = buffer.getNumSamples();
-        auto sampleRate = getSampleRate();
+        auto numInputChannels = juce::jmin(getTotalNumInputChannels(), buffer.getNumChannels());
 
-        // Clear the output buffer
-        buffer.clear();
-
-        // Create a buffer for test tones
-        juce::AudioBuffer<float> testToneBuffer(1, numSamples);
-        float* testToneData = testToneBuffer.getWritePointer(0);
-
-        // Generate test tones (440Hz, 880Hz, and 1760Hz)
-        for (int i = 0; i < numSamples; ++i)
+        if (!quantumFifo.isPrepared())
         {
-            testToneData[i] =  2.0f * (phase440Hz - std::floor(phase440Hz + 0.5f));
-            // Update phases
-            phase440Hz += 440.0 / sampleRate;
-            if (phase440Hz >= 1.0) phase440Hz -= 1.0;
-
+            buffer.clear();
+            return;
         }
 
-        // Apply level decay to all microphones
-        for (int i = 0; i < 3; ++i)
+        // Output-only channels hold garbage on entry; don't feed it to the FIFO
+        for (int channel = numInputChannels; channel < buffer.getNumChannels(); ++channel)
         {
-            micLevels[i] *= levelDecayRate; // Apply decay rate
+            buffer.clear(channel, 0, buffer.getNumSamples());
         }
 
-        // Process through chamber using test tones instead of input data
-        if (!bypassProcessing)
+        // The host buffer holds the input on entry and receives the output in
+        // place, delayed by one quantum (and one host block when pipelined)
+        juce::dsp::AudioBlock<float> hostBlock(buffer);
+        
+        if (pipeline.isPrepared())
         {
-            // Make sure bypass is disabled
-            chamber.setBypassProcessing(false);
+            pipelineInputChannels.store(numInputChannels, std::memory_order_relaxed);
+            pipeline.process(hostBlock);
         }
         else
         {
-            // When bypass is enabled, just use the test tone directly
-            // This will allow us to hear the unprocessed test tone
-            chamber.setBypassProcessing(true);
+            processThroughQuantumFifo(hostBlock, numInputChannels);
         }
-        chamber.processBlock(testToneData, numSamples);
-
-        // Mix microphone outputs
-        bool anySolo = *parameters.getRawParameterValue("mic1Solo") > 0.5f ||
-                       *parameters.getRawParameterValue("mic2Solo") > 0.5f ||
-                       *parameters.getRawParameterValue("mic3Solo") > 0.5f;
-
-        // Get microphone parameters
-        float mic1Vol = *parameters.getRawParameterValue("mic1Volume");
-        float mic2Vol = *parameters.getRawParameterValue("mic2Volume");
-        float mic3Vol = *parameters.getRawParameterValue("mic3Volume");
-        bool mic1Solo = *parameters.getRawParameterValue("mic1Solo") > 0.5f;
-        bool mic2Solo = *parameters.getRawParameterValue("mic2Solo") > 0.5f;
-        bool mic3Solo = *parameters.getRawParameterValue("mic3Solo") > 0.5f;
-        bool mic1Mute = *parameters.getRawParameterValue("mic1Mute") > 0.5f;
-        bool mic2Mute = *parameters.getRawParameterValue("mic2Mute") > 0.5f;
-        bool mic3Mute = *parameters.getRawParameterValue("mic3Mute") > 0.5f;
-
-        // Get output buffer pointers
-        float* leftChannel = buffer.getWritePointer(0);
-        float* rightChannel = buffer.getWritePointer(1);
-
-        // Create temporary buffers for microphone outputs
-        juce::AudioBuffer<float> mic1Buffer(1, numSamples);
-        juce::AudioBuffer<float> mic2Buffer(1, numSamples);
-        juce::AudioBuffer<float> mic3Buffer(1, numSamples);
         
-        float* mic1Data = mic1Buffer.getWritePointer(0);
-        float* mic2Data = mic2Buffer.getWritePointer(0);
-        float* mic3Data = mic3Buffer.getWritePointer(0);
+        if (processBlockCounter % 1000 == 0) {
+            RIPPLE_LOG(Audio, Trace, "processBlock completed successfully");
+        }
+    }
+    catch (const std::exception& e) {
+        RIPPLE_LOG(Audio, Error, "Exception in processBlock: {}", e.what());
+    }
+    catch (...) {
+        RIPPLE_LOG(Audio, Error, "Unknown exception in processBlock");
+    }
+}
+
+void RippleatorAudioProcessor::processThroughQuantumFifo(const juce::dsp::AudioBlock<float>& block, int numInputChannels)
+{
+    quantumFifo.process(block, [this, numInputChannels](const juce::dsp::AudioBlock<float>& quantum)
+    {
+        processQuantum(quantum, numInputChannels);
+    });
+}
+
+void RippleatorAudioProcessor::processQuantum(const juce::dsp::AudioBlock<float>& block, int numInputChannels)
+{
+    constexpr int numSamples = QuantumFifo::QUANTUM_SIZE;
+    jassert(static_cast<int>(block.getNumSamples()) == numSamples);
+
+    // Read-only view of the host input channels; the chamber reads them in place
+    auto inputChannels = block.getSubsetChannelBlock(0, static_cast<size_t>(numInputChannels));
+    juce::dsp::AudioBlock<const float> input(inputChannels);
+
+    for (int channel = 0; channel < juce::jmin(numInputChannels, static_cast<int>(inputMeters.size())); ++channel)
+    {
+        inputMeters[static_cast<size_t>(channel)].process(input.getChannelPointer(static_cast<size_t>(channel)), numSamples);
+    }
 
-        chamber.getMicrophoneOutputBlock(0, mic1Data, numSamples);
-        chamber.getMicrophoneOutputBlock(1, mic2Data, numSamples);
-        chamber.getMicrophoneOutputBlock(2, mic3Data, numSamples);
+    wetGain.setTargetValue(bypassProcessing.load() ? 0.0f : 1.0f);
+    
+    // Fully bypassed: the host input is already in place, so the chamber,
+    // routing and mic metering are skipped entirely
+    if (!wetGain.isSmoothing() && wetGain.getTargetValue() == 0.0f)
+    {
+        if (!fullyBypassed)
+        {
+            for (auto& meter : micMeters)
+            {
+                meter.reset();
+            }
+            fullyBypassed = true;
+        }
+        
+        float* dryChannels[] = { block.getChannelPointer(0), block.getChannelPointer(1) };
+        outputMeters[0].process(dryChannels[0], numSamples);
+        outputMeters[1].process(dryChannels[1], numSamples);
+        outputLoudness.process(dryChannels, 2, numSamples);
+        return;
+    }
+    
+    fullyBypassed = false;
+    
+    // Keep the dry signal for the bypass crossfade; processing overwrites the block
+    const bool chamberArray = numChannelChambers.load(std::memory_order_relaxed) > 0;
+    const int numWetChannels = chamberArray ? static_cast<int>(block.getNumChannels()) : 2;
+    const bool crossfading = wetGain.isSmoothing();
+    if (crossfading)
+    {
+        for (int channel = 0; channel < numWetChannels; ++channel)
+        {
+            dryBuffer.copyFrom(channel, 0, block.getChannelPointer(static_cast<size_t>(channel)), numSamples);
+        }
+    }
 
+    if (chamberArray)
+    {
+        processChamberArray(block);
+    }
+    else
+    {
+        // Mics are rendered into the mic bus, then mixed back over the host channels
+        juce::dsp::AudioBlock<float> micOutputs(micScratchBuffer);
+        chamber.process(input, micOutputs);
 
-        // Update level meters with peak values
-        for (int i = 0; i < numSamples; ++i) {
-            updateMicrophoneLevel(0, std::abs(mic1Data[i]));
-            updateMicrophoneLevel(1, std::abs(mic2Data[i]));
-            updateMicrophoneLevel(2, std::abs(mic3Data[i]));
+        const float* micChannels[Chamber::NUM_MICROPHONES];
+        for (int mic = 0; mic < Chamber::NUM_MICROPHONES; ++mic)
+        {
+            micChannels[mic] = micOutputs.getChannelPointer(static_cast<size_t>(mic));
+            micMeters[static_cast<size_t>(mic)].process(micChannels[mic], numSamples);
         }
 
-        // Process each sample in the block
+        // Mix microphone outputs to stereo through the routing matrix
+        updateRoutingGains();
+        
+        float* stereoChannels[] = { block.getChannelPointer(0), block.getChannelPointer(1) };
+        routingMatrix.process(micChannels, stereoChannels, numSamples);
+    }
+    
+    if (crossfading)
+    {
         for (int i = 0; i < numSamples; ++i)
         {
-            // Get microphone outputs
-            float mic1Output = mic1Data[i];
-            float mic2Output = mic2Data[i];
-            float mic3Output = mic3Data[i];
+            bypassRamp[static_cast<size_t>(i)] = wetGain.getNextValue();
+        }
+        
+        // out = dry + (wet - dry) * gain
+        for (int channel = 0; channel < numWetChannels; ++channel)
+        {
+            float* wet = block.getChannelPointer(static_cast<size_t>(channel));
+            juce::FloatVectorOperations::subtract(wet, dryBuffer.getReadPointer(channel), numSamples);
+            juce::FloatVectorOperations::multiply(wet, bypassRamp.data(), numSamples);
+            juce::FloatVectorOperations::add(wet, dryBuffer.getReadPointer(channel), numSamples);
+        }
+    }
+    
+    // Meters and loudness follow the front pair
+    float* outputChannels[] = { block.getChannelPointer(0), block.getChannelPointer(1) };
+    
+    outputMeters[0].process(outputChannels[0], numSamples);
+    outputMeters[1].process(outputChannels[1], numSamples);
+    
+    outputLoudness.process(outputChannels, 2, numSamples);
+}
+
+std::array<float, Chamber::NUM_MICROPHONES> RippleatorAudioProcessor::getMicGains() const
+{
+    bool anySolo = false;
+    for (auto* solo : micSoloParameters)
+    {
+        anySolo = anySolo || solo->load() > 0.5f;
+    }
+    
+    const float outputGain = outputGainParameter->load();
+    std::array<float, Chamber::NUM_MICROPHONES> gains {};
+    
+    for (int mic = 0; mic < Chamber::NUM_MICROPHONES; ++mic)
+    {
+        const bool audible = anySolo ? micSoloParameters[mic]->load() > 0.5f
+                                     : micMuteParameters[mic]->load() <= 0.5f;
+        gains[static_cast<size_t>(mic)] = audible ? micVolumeParameters[mic]->load() * outputGain : 0.0f;
+    }
+    
+    return gains;
+}
+
+void RippleatorAudioProcessor::updateRoutingGains()
+{
+    // Fold volume, solo/mute and output gain into the pan matrix once per block
+    const auto micGains = getMicGains();
+    
+    for (int mic = 0; mic < Chamber::NUM_MICROPHONES; ++mic)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            routingMatrix.setTargetGain(mic, channel, micPanGains[mic][channel] * micGains[static_cast<size_t>(mic)]);
+        }
+    }
+}
+
+void RippleatorAudioProcessor::processChamberArray(const juce::dsp::AudioBlock<float>& block)
+{
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    const int numChambers = juce::jmin(static_cast<int>(block.getNumChannels()),
+                                       numChannelChambers.load(std::memory_order_relaxed) + 1);
+    
+    // Without panning each channel hears every mic in full; scale to the level
+    // one stereo channel gets from the default pans
+    const auto micGains = getMicGains();
+    for (int mic = 0; mic < Chamber::NUM_MICROPHONES; ++mic)
+    {
+        chamberBank.setTargetGain(mic, micGains[static_cast<size_t>(mic)] * ARRAY_MIC_GAIN);
+    }
+    
+    float* bankChannels[ChamberFilterBank::MAX_CHAMBERS];
+    const int numLanes = numChambers - 1;
+    
+    for (int index = 0; index < numChambers; ++index)
+    {
+        Chamber& source = index == 0 ? chamber : *channelChambers[static_cast<size_t>(index - 1)];
+        float* channel = block.getChannelPointer(static_cast<size_t>(index));
+        
+        // The first chamber feeds the editor's streams and mic meters, and the
+        // bank only knows one speaker, so these render their own mics
+        const bool ownMics = index == 0 || source.getNumFilteredSpeakers() > 1;
+        const int lane = index - 1;
+        
+        if (lane >= 0)
+        {
+            const auto laneIndex = static_cast<size_t>(lane);
+            if (laneInBank[laneIndex] == ownMics)
+                chamberBank.resetChamber(lane);
             
-            // Apply volume
-            mic1Output *= mic1Vol;
-            mic2Output *= mic2Vol;
-            mic3Output *= mic3Vol;
+            laneInBank[laneIndex] = !ownMics;
             
-            // Apply solo/mute
-            if (anySolo)
+            if (ownMics)
             {
-                // Solo mode
-                if (!mic1Solo) mic1Output = 0.0f;
-                if (!mic2Solo) mic2Output = 0.0f;
-                if (!mic3Solo) mic3Output = 0.0f;
+                bankChannels[lane] = bankScratchBuffer.getWritePointer(lane);
+                juce::FloatVectorOperations::clear(bankChannels[lane], numSamples);
             }
             else
             {
-                // Mute mode
-                if (mic1Mute) mic1Output = 0.0f;
-                if (mic2Mute) mic2Output = 0.0f;
-                if (mic3Mute) mic3Output = 0.0f;
+                bankChannels[lane] = channel;
             }
+        }
+        
+        if (ownMics)
+        {
+            const float* channelInput[] = { channel };
+            juce::dsp::AudioBlock<const float> input(channelInput, 1, static_cast<size_t>(numSamples));
+            juce::dsp::AudioBlock<float> micOutputs(micScratchBuffer);
+            source.process(input, micOutputs);
             
-            // Mix to stereo (simple panning)
-            leftChannel[i] = 0.7f * mic1Output + 0.5f * mic2Output + 0.3f * mic3Output;
-            rightChannel[i] = 0.3f * mic1Output + 0.5f * mic2Output + 0.7f * mic3Output;
+            const float* micChannels[Chamber::NUM_MICROPHONES];
+            for (int mic = 0; mic < Chamber::NUM_MICROPHONES; ++mic)
+            {
+                micChannels[mic] = micOutputs.getChannelPointer(static_cast<size_t>(mic));
+                if (index == 0)
+                    micMeters[static_cast<size_t>(mic)].process(micChannels[mic], numSamples);
+            }
+            
+            chamberBank.mixMicrophones(micChannels, channel, numSamples);
+            continue;
         }
-
-        // Apply output gain
-        float outputGain = *parameters.getRawParameterValue("outputGain");
-        buffer.applyGain(outputGain);
         
-        if (processBlockCounter % 1000 == 0) {
-            DebugLogger::logWithCategory("AUDIO", "processBlock completed successfully");
+        // Each chamber's tracer publishes its own responses; pick up the current
+        // ones. A set the message thread is rewriting right now is picked up next quantum.
+        for (int mic = 0; mic < Chamber::NUM_MICROPHONES; ++mic)
+        {
+            if (source.copyMicCoefficients(mic, 0, arrayCoefficients))
+                chamberBank.setCoefficients(lane, mic, arrayCoefficients);
         }
     }
-    catch (const std::exception& e) {
-        DebugLogger::logWithCategory("ERROR", "Exception in processBlock: " + std::string(e.what()));
-    }
-    catch (...) {
-        DebugLogger::logWithCategory("ERROR", "Unknown exception in processBlock");
-    }
+    
+    chamberBank.process(bankChannels, numLanes, numSamples);
 }
 
-void RippleatorAudioProcessor::updateMicrophoneLevel(int micIndex, float level)
+void RippleatorAudioProcessor::updateActiveMicrophones()
 {
-    if (micIndex >= 0 && micIndex < 3)
+    // Same audibility rule as updateRoutingGains(): a mic whose routing gain is
+    // forced to zero doesn't need to be traced or filtered
+    bool anySolo = false;
+    for (auto* solo : micSoloParameters)
     {
-        // Take the absolute value of the level
-        level = std::abs(level);
-        
-        // Update the level if the new level is higher
-        if (level > micLevels[micIndex])
-        {
-            micLevels[micIndex] = level;
-        }
-        
-        // Apply smoothing for the meter display
-        const float smoothingFactor = 0.7f;
-        micLevelSmoothed[micIndex] = smoothingFactor * micLevelSmoothed[micIndex] + 
-                                    (1.0f - smoothingFactor) * micLevels[micIndex];
+        anySolo = anySolo || solo->load() > 0.5f;
     }
+    
+    for (int mic = 0; mic < Chamber::NUM_MICROPHONES; ++mic)
+    {
+        const bool audible = anySolo ? micSoloParameters[mic]->load() > 0.5f
+                                     : micMuteParameters[mic]->load() <= 0.5f;
+        const bool active = microphoneEnabled[mic] && audible;
+        forEachArrayChamber([mic, active](Chamber& arrayChamber) { arrayChamber.setMicrophoneActive(mic, active); });
+    }
+}
+
+float RippleatorAudioProcessor::getMicrophoneLevel(int micIndex) const
+{
+    if (micIndex < 0 || micIndex >= Chamber::NUM_MICROPHONES)
+        return ChannelMeter::MIN_DB;
+    
+    return micMeters[micIndex].getPeakDecibels();
+}
+
+float RippleatorAudioProcessor::getInputLevel() const
+{
+    return juce::jmax(inputMeters[0].getPeakDecibels(), inputMeters[1].getPeakDecibels());
+}
+
+float RippleatorAudioProcessor::getOutputLevel() const
+{
+    return juce::jmax(outputMeters[0].getPeakDecibels(), outputMeters[1].getPeakDecibels());
+}
+
+void RippleatorAudioProcessor::setLoudnessMeteringEnabled(bool enabled)
+{
+    outputLoudness.setEnabled(enabled);
+}
+
+float RippleatorAudioProcessor::getOutputLoudness() const
+{
+    return outputLoudness.getShortTermLoudness();
 }
 
 void RippleatorAudioProcessor::setMicrophonePosition(int index, float x, float y)
@@ -428,13 +774,13 @@ void RippleatorAudioProcessor::setMicrophoneEnabled(int index, bool enabled)
     if (index >= 0 && index < 3)
     {
         microphoneEnabled[index] = enabled;
+        updateActiveMicrophones();
     }
 }
 
 void RippleatorAudioProcessor::setBypassProcessing(bool bypass)
 {
     bypassProcessing = bypass;
-    chamber.setBypassProcessing(bypass);
 }
 
 bool RippleatorAudioProcessor::isBypassProcessingEnabled() const
@@ -456,10 +802,111 @@ void RippleatorAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     auto state = parameters.copyState();
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    
+    juce::MemoryBlock parameterData;
+    copyXmlToBinary(*xml, parameterData);
+    
+    // Header, size-prefixed parameter XML, then the chamber's scene chunk
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(STATE_MAGIC);
+    stream.writeCompressedInt(STATE_VERSION);
+    stream.writeCompressedInt(static_cast<int>(parameterData.getSize()));
+    stream.write(parameterData.getData(), parameterData.getSize());
+    chamber.writeScene(stream);
+    
+    // Channel chambers that don't exist in the current layout keep their restored scene
+    const auto numChannelScenes = juce::jmax(channelChambers.size(), pendingChannelScenes.size());
+    stream.writeCompressedInt(static_cast<int>(numChannelScenes));
+    
+    for (size_t index = 0; index < numChannelScenes; ++index)
+    {
+        juce::MemoryBlock scene;
+        if (index < channelChambers.size())
+        {
+            juce::MemoryOutputStream sceneStream(scene, false);
+            channelChambers[index]->writeScene(sceneStream);
+        }
+        else
+        {
+            scene = pendingChannelScenes[index];
+        }
+        
+        stream.writeCompressedInt(static_cast<int>(scene.getSize()));
+        stream.write(scene.getData(), scene.getSize());
+    }
 }
 
 void RippleatorAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes), false);
+    
+    // States saved before the scene was stored are the parameter XML alone
+    if (sizeInBytes < 4 || stream.readInt() != STATE_MAGIC)
+    {
+        restoreParameters(data, sizeInBytes);
+        return;
+    }
+    
+    const int version = stream.readCompressedInt();
+    const int parameterSize = stream.readCompressedInt();
+    if (version < 1 || version > STATE_VERSION || parameterSize < 0 || parameterSize > stream.getNumBytesRemaining())
+    {
+        RIPPLE_LOG(Init, Warning, "Ignoring unreadable plugin state (version {})", version);
+        return;
+    }
+    
+    juce::MemoryBlock parameterData(static_cast<size_t>(parameterSize));
+    stream.read(parameterData.getData(), parameterSize);
+    
+    // Parameters and scene land in one transaction, so at most one evaluation follows
+    Chamber::ScopedEdit sceneEdit(chamber);
+    restoreParameters(parameterData.getData(), parameterSize);
+    
+    if (!chamber.readScene(stream))
+    {
+        RIPPLE_LOG(Init, Warning, "Ignoring unreadable chamber scene in plugin state");
+        return;
+    }
+    
+    if (version >= 2)
+        restoreChannelScenes(stream);
+}
+
+void RippleatorAudioProcessor::restoreChannelScenes(juce::InputStream& stream)
+{
+    const int numChannelScenes = stream.readCompressedInt();
+    if (numChannelScenes < 0 || numChannelScenes >= ChamberFilterBank::MAX_CHAMBERS)
+    {
+        RIPPLE_LOG(Init, Warning, "Ignoring {} channel chamber scenes in plugin state", numChannelScenes);
+        return;
+    }
+    
+    std::vector<juce::MemoryBlock> scenes;
+    for (int index = 0; index < numChannelScenes; ++index)
+    {
+        const int sceneSize = stream.readCompressedInt();
+        if (sceneSize < 0 || sceneSize > stream.getNumBytesRemaining())
+        {
+            RIPPLE_LOG(Init, Warning, "Ignoring truncated channel chamber scenes in plugin state");
+            return;
+        }
+        
+        scenes.emplace_back(static_cast<size_t>(sceneSize));
+        stream.read(scenes.back().getData(), sceneSize);
+    }
+    
+    // Chambers that exist take theirs now; the rest when the layout creates them
+    for (size_t index = 0; index < juce::jmin(scenes.size(), channelChambers.size()); ++index)
+    {
+        juce::MemoryInputStream sceneStream(scenes[index], false);
+        if (!channelChambers[index]->readScene(sceneStream))
+            RIPPLE_LOG(Init, Warning, "Ignoring unreadable scene for channel chamber {}", static_cast<int>(index) + 1);
+    }
+    
+    pendingChannelScenes = std::move(scenes);
+}
+
+void RippleatorAudioProcessor::restoreParameters(const void* data, int sizeInBytes)
 {
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState.get() != nullptr)
@@ -472,6 +919,14 @@ Chamber& RippleatorAudioProcessor::getChamber()
     return chamber;
 }
 
+Chamber& RippleatorAudioProcessor::getArrayChamber(int channel)
+{
+    if (channel <= 0 || channel > static_cast<int>(channelChambers.size()))
+        return chamber;
+    
+    return *channelChambers[static_cast<size_t>(channel - 1)];
+}
+
 juce::AudioProcessorValueTreeState& RippleatorAudioProcessor::getParameters()
 {
     return parameters;
@@ -2,6 +2,11 @@
 
 #include <JuceHeader.h>
 #include "Models/Chamber.h"
+#include "DSP/Metering.h"
+#include "DSP/RoutingMatrix.h"
+#include "DSP/QuantumFifo.h"
+#include "DSP/BlockPipeline.h"
+#include "DSP/ChamberFilterBank.h"
 
 class RippleatorAudioProcessor : public juce::AudioProcessor,
                                public juce::AudioProcessorValueTreeState::Listener
@@ -41,11 +46,21 @@ public:
     Chamber& getChamber();
     juce::AudioProcessorValueTreeState& getParameters();
     
-    // Get the current level for a microphone (0-1 range)
-    float getMicrophoneLevel(int micIndex) const {return 0.5;}
+    // Chamber array mode: one chamber per channel, 0 being getChamber(). A
+    // layout of up to two channels has only that one. Chambers outlive the
+    // layouts that use them, so a returned reference stays valid.
+    int getNumArrayChambers() const { return numChannelChambers.load(std::memory_order_acquire) + 1; }
+    Chamber& getArrayChamber(int channel);
     
-    // Helper method to update microphone levels
-    void updateMicrophoneLevel(int micIndex, float level);
+    // Metering, safe to call from the GUI thread (levels in dB)
+    float getMicrophoneLevel(int micIndex) const;
+    const ChannelMeter& getMicrophoneMeter(int micIndex) const { return micMeters[micIndex]; }
+    float getInputLevel() const;
+    float getOutputLevel() const;
+    
+    // Short-term output loudness in LUFS; only measured while enabled
+    void setLoudnessMeteringEnabled(bool enabled);
+    float getOutputLoudness() const;
     
     void setMicrophonePosition(int index, float x, float y);
     void setMicrophoneEnabled(int index, bool enabled);
@@ -61,17 +76,105 @@ private:
     
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
-    std::array<float, 3> micLevels;
-    std::array<float, 3> micLevelSmoothed;
-    std::array<bool, 3> microphoneEnabled;
-    float levelDecayRate;
+    // Re-block through the QuantumFifo and process each quantum in place
+    void processThroughQuantumFifo(const juce::dsp::AudioBlock<float>& block, int numInputChannels);
+    
+    // Process one QuantumFifo::QUANTUM_SIZE block in place
+    void processQuantum(const juce::dsp::AudioBlock<float>& block, int numInputChannels);
+    
+    // Volume * solo/mute * output gain of each mic, from the current parameter values
+    std::array<float, Chamber::NUM_MICROPHONES> getMicGains() const;
+    
+    // Set the routing matrix targets from the current parameter values
+    void updateRoutingGains();
+    
+    // Chamber array mode: filter every channel through its own chamber, in place
+    void processChamberArray(const juce::dsp::AudioBlock<float>& block);
+    
+    // Create and prepare the per-channel chambers the channel count needs
+    void prepareChannelChambers(int numChannels, double sampleRate);
+    
+    // Tell the chamber which mics are enabled and audible after solo/mute
+    void updateActiveMicrophones();
+    
+    // Call function(Chamber&) for `chamber` and each channel chamber the layout
+    // uses; safe from any thread, as channelChambers never reallocates
+    template <typename Function>
+    void forEachArrayChamber(Function&& function)
+    {
+        function(chamber);
+        
+        const int numInUse = numChannelChambers.load(std::memory_order_acquire);
+        for (int index = 0; index < numInUse; ++index)
+            function(*channelChambers[static_cast<size_t>(index)]);
+    }
+    
+    // Plugin state: the parameter XML followed by the chamber's scene chunk,
+    // then (from version 2) the size-prefixed scenes of the channel chambers
+    static constexpr int STATE_MAGIC = 0x54535052;     // "RPST"
+    static constexpr int STATE_VERSION = 2;
+    void restoreParameters(const void* data, int sizeInBytes);
+    void restoreChannelScenes(juce::InputStream& stream);
+    
+    // Mic-to-stereo mix; cell gains are pan * volume * solo/mute * output gain
+    RoutingMatrix routingMatrix;
+    std::array<std::array<float, 2>, Chamber::NUM_MICROPHONES> micPanGains { { { 0.7f, 0.3f }, { 0.5f, 0.5f }, { 0.3f, 0.7f } } };
     
-    // Phase accumulators for test tone generation
-    double phase440Hz = 0.0;
-    double phase880Hz = 0.0;
-    double phase1760Hz = 0.0;
+    // Parameter handles, looked up once at construction
+    std::atomic<float>* outputGainParameter = nullptr;
+    std::array<std::atomic<float>*, Chamber::NUM_MICROPHONES> micVolumeParameters {};
+    std::array<std::atomic<float>*, Chamber::NUM_MICROPHONES> micSoloParameters {};
+    std::array<std::atomic<float>*, Chamber::NUM_MICROPHONES> micMuteParameters {};
+    
+    // Chamber array mode, for more than two channels: channel 0 goes through
+    // `chamber`, every further channel through its own chamber. Chambers with
+    // one speaker run side by side in the bank; channel 0's (for its streams
+    // and meters) and any with several speakers run through Chamber::process.
+    // Only the first numChannelChambers are in use; the rest wait for a
+    // layout with more channels.
+    std::vector<std::unique_ptr<Chamber>> channelChambers;
+    std::atomic<int> numChannelChambers { 0 };
+    ChamberFilterBank chamberBank;
+    static constexpr float ARRAY_MIC_GAIN = 0.5f;      // default pans put 1.5 of the mics in each stereo channel
+    MicFrequencyBands arrayCoefficients;                // audio thread scratch for consistent coefficient copies
+    
+    // Channel chamber i always has bank lane i. A chamber rendered by
+    // Chamber::process leaves its lane filtering silence into a scratch
+    // channel, and the lane is cleared whenever its chamber switches path
+    // (audio thread).
+    juce::AudioBuffer<float> bankScratchBuffer;
+    std::array<bool, ChamberFilterBank::MAX_CHAMBERS> laneInBank {};
+    
+    // Scene chunks of channel chambers restored from a state but not created yet
+    std::vector<juce::MemoryBlock> pendingChannelScenes;
+    
+    // Re-blocks host audio so the chamber, routing and meters always see one block size
+    QuantumFifo quantumFifo;
+    
+    // Optional: runs the QuantumFifo and everything after it one host block behind, on its own thread
+    BlockPipeline pipeline;
+    std::atomic<int> pipelineInputChannels { 0 };
+    
+    // Scratch buffers, sized in prepareToPlay so processBlock never allocates
+    juce::AudioBuffer<float> micScratchBuffer;
+    juce::AudioBuffer<float> dryBuffer;
+    std::vector<float> bypassRamp;
+    
+    // Crossfade between the chamber output (1) and the dry input (0) when bypass changes
+    static constexpr double BYPASS_FADE_SECONDS = 0.02;
+
+    juce::SmoothedValue<float> wetGain;
+    bool fullyBypassed = false;
+    
+    // Meters, written by processBlock and read by the editor
+    std::array<ChannelMeter, 2> inputMeters;
+    std::array<ChannelMeter, Chamber::NUM_MICROPHONES> micMeters;
+    std::array<ChannelMeter, 2> outputMeters;
+    LoudnessMeter outputLoudness;
+    
+    std::array<bool, 3> microphoneEnabled;
     
-    bool bypassProcessing = false;
+    std::atomic<bool> bypassProcessing { false };
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RippleatorAudioProcessor)
@@ -0,0 +1,67 @@
+#include "AllocationGuard.h"
+
+#if RIPPLEATOR_ALLOCATION_GUARD
+
+#include <cstdlib>
+#include <new>
+
+void ScopedAllocationGuard::checkAllocation() noexcept
+{
+    auto& depth = getDepth();
+
+    if (depth > 0)
+    {
+        // Lift the guard while asserting: reporting the assertion may itself allocate
+        const int savedDepth = depth;
+        depth = 0;
+
+        // Heap allocation inside a ScopedAllocationGuard (e.g. on the audio thread)
+        jassertfalse;
+
+        depth = savedDepth;
+    }
+}
+
+namespace
+{
+    void* allocate(std::size_t size)
+    {
+        ScopedAllocationGuard::checkAllocation();
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* p = allocate(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* p = allocate(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept                        { std::free(p); }
+void operator delete[](void* p) noexcept                      { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept           { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept         { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept   { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif
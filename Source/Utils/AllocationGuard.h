@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Debug builds replace the global operator new so that an allocation inside a
+// ScopedAllocationGuard trips an assertion. Define RIPPLEATOR_ALLOCATION_GUARD=0
+// to turn the check off (or =1 to force it on in release builds).
+#ifndef RIPPLEATOR_ALLOCATION_GUARD
+ #if JUCE_DEBUG
+  #define RIPPLEATOR_ALLOCATION_GUARD 1
+ #else
+  #define RIPPLEATOR_ALLOCATION_GUARD 0
+ #endif
+#endif
+
+/**
+ * Marks a scope on the current thread, typically the audio callback, in which
+ * heap allocation is a bug. With RIPPLEATOR_ALLOCATION_GUARD enabled any call to
+ * operator new from inside the scope hits jassertfalse; otherwise this is empty.
+ */
+class ScopedAllocationGuard
+{
+public:
+#if RIPPLEATOR_ALLOCATION_GUARD
+    ScopedAllocationGuard() noexcept { ++getDepth(); }
+    ~ScopedAllocationGuard() noexcept { --getDepth(); }
+
+    /** Called by the replaced operator new for every allocation. */
+    static void checkAllocation() noexcept;
+
+private:
+    static int& getDepth() noexcept
+    {
+        thread_local int depth = 0;
+        return depth;
+    }
+#else
+    ScopedAllocationGuard() noexcept {}
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllocationGuard)
+};
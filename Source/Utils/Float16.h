@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * IEEE 754 half-precision storage helpers.
+ *
+ * Used to keep large precomputed tables compact; values are converted back to
+ * float before any arithmetic. Conversion rounds to nearest and handles
+ * subnormals, infinities and NaN.
+ */
+namespace Float16
+{
+    inline uint16_t fromFloat(float value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+        const auto magnitude = bits & 0x7fffffffu;
+
+        if (magnitude > 0x7f800000u)
+            return static_cast<uint16_t>(sign | 0x7e00u);       // NaN
+
+        const int exponent = static_cast<int>(magnitude >> 23) - 127 + 15;
+        uint32_t mantissa = magnitude & 0x7fffffu;
+
+        if (exponent >= 31)
+            return static_cast<uint16_t>(sign | 0x7c00u);       // Overflow to infinity
+
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+                return sign;                                    // Underflow to zero
+
+            // Subnormal: shift the implicit leading one into the mantissa
+            mantissa |= 0x800000u;
+            const int shift = 14 - exponent;
+            auto half = static_cast<uint16_t>(mantissa >> shift);
+
+            if ((mantissa >> (shift - 1)) & 1u)
+                ++half;
+
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        auto half = static_cast<uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+
+        // Round to nearest; a carry into the exponent is the correct result
+        if (mantissa & 0x1000u)
+            ++half;
+
+        return half;
+    }
+
+    inline float toFloat(uint16_t half) noexcept
+    {
+        const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+        int exponent = (half >> 10) & 0x1f;
+        uint32_t mantissa = half & 0x3ffu;
+        uint32_t bits;
+
+        if (exponent == 0)
+        {
+            if (mantissa == 0)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // Normalise the subnormal
+                exponent = 1;
+                while ((mantissa & 0x400u) == 0)
+                {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+
+                bits = sign | (static_cast<uint32_t>(exponent + 112) << 23) | ((mantissa & 0x3ffu) << 13);
+            }
+        }
+        else if (exponent == 31)
+        {
+            bits = sign | 0x7f800000u | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | (static_cast<uint32_t>(exponent + 112) << 23) | (mantissa << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
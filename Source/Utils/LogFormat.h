@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/**
+ * Log record and binary log file definitions.
+ *
+ * This header has no JUCE dependency so that the offline log decoder
+ * (Tools/LogDecoder) can share it with the plugin's DebugLogger.
+ */
+
+enum class LogLevel : uint8_t
+{
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+enum class LogCategory : uint8_t
+{
+    Init,       // bit 0
+    Audio,      // bit 1
+    Chamber,    // bit 2
+    Ray,        // bit 3
+    Tracer,     // bit 4
+    Gui,        // bit 5
+    Logger      // bit 6
+};
+
+inline const char* getLogCategoryName(LogCategory category)
+{
+    switch (category)
+    {
+        case LogCategory::Init:    return "INIT";
+        case LogCategory::Audio:   return "AUDIO";
+        case LogCategory::Chamber: return "CHAMBER";
+        case LogCategory::Ray:     return "RAY";
+        case LogCategory::Tracer:  return "TRACER";
+        case LogCategory::Gui:     return "GUI";
+        case LogCategory::Logger:  return "LOGGER";
+    }
+
+    return "?";
+}
+
+inline const char* getLogLevelName(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::Trace:   return "TRACE";
+        case LogLevel::Debug:   return "DEBUG";
+        case LogLevel::Info:    return "INFO";
+        case LogLevel::Warning: return "WARNING";
+        case LogLevel::Error:   return "ERROR";
+        case LogLevel::Off:     break;
+    }
+
+    return "?";
+}
+
+/**
+ * Captured arguments of one log call.
+ * Holds up to MAX_ARGS values; string arguments are copied (and truncated)
+ * into the inline string area so the payload is trivially copyable.
+ */
+struct LogArgs
+{
+    static constexpr int MAX_ARGS = 6;
+    static constexpr int STRING_BYTES = 48;
+
+    enum class ArgType : uint8_t { Int, UInt, Double, Bool, String };
+
+    union Arg
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        struct { uint8_t offset; uint8_t length; } s;
+    };
+
+    uint8_t numArgs = 0;
+    uint8_t stringBytesUsed = 0;
+    ArgType types[MAX_ARGS] = {};
+    Arg args[MAX_ARGS] = {};
+    char strings[STRING_BYTES] = {};
+
+    template <typename T>
+    void capture(const T& value) noexcept
+    {
+        using Type = std::decay_t<T>;
+        auto& arg = args[numArgs];
+
+        if constexpr (std::is_same_v<Type, bool>)
+        {
+            types[numArgs] = ArgType::Bool;
+            arg.u = value ? 1 : 0;
+        }
+        else if constexpr (std::is_floating_point_v<Type>)
+        {
+            types[numArgs] = ArgType::Double;
+            arg.d = static_cast<double>(value);
+        }
+        else if constexpr (std::is_enum_v<Type>)
+        {
+            types[numArgs] = ArgType::Int;
+            arg.i = static_cast<int64_t>(value);
+        }
+        else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>)
+        {
+            types[numArgs] = ArgType::Int;
+            arg.i = static_cast<int64_t>(value);
+        }
+        else if constexpr (std::is_integral_v<Type>)
+        {
+            types[numArgs] = ArgType::UInt;
+            arg.u = static_cast<uint64_t>(value);
+        }
+        else if constexpr (std::is_same_v<Type, std::string>)
+        {
+            captureString(value.data(), value.size());
+        }
+        else
+        {
+            static_assert(std::is_convertible_v<const T&, const char*>,
+                          "RIPPLE_LOG arguments must be arithmetic, enums or C strings");
+            const char* text = value;
+            captureString(text, text != nullptr ? std::strlen(text) : 0);
+        }
+
+        ++numArgs;
+    }
+
+    std::string argToString(int index) const
+    {
+        const auto& arg = args[index];
+
+        switch (types[index])
+        {
+            case ArgType::Int:    return std::to_string(arg.i);
+            case ArgType::UInt:   return std::to_string(arg.u);
+            case ArgType::Double: return std::to_string(arg.d);
+            case ArgType::Bool:   return arg.u != 0 ? "true" : "false";
+            case ArgType::String: return std::string(strings + arg.s.offset, std::min<size_t>(arg.s.length, STRING_BYTES));
+        }
+
+        return {};
+    }
+
+    /** Substitute the captured arguments into the "{}" placeholders of a format string. */
+    std::string format(const char* formatString) const
+    {
+        std::string result;
+        int argIndex = 0;
+
+        for (const char* p = formatString; p != nullptr && *p != 0; ++p)
+        {
+            if (p[0] == '{' && p[1] == '}' && argIndex < numArgs)
+            {
+                result += argToString(argIndex++);
+                ++p;
+            }
+            else
+            {
+                result += *p;
+            }
+        }
+
+        return result;
+    }
+
+private:
+    void captureString(const char* text, size_t length) noexcept
+    {
+        auto& arg = args[numArgs];
+        types[numArgs] = ArgType::String;
+
+        const size_t available = static_cast<size_t>(STRING_BYTES - stringBytesUsed);
+        const size_t toCopy = std::min(length, available);
+
+        if (toCopy > 0)
+            std::memcpy(strings + stringBytesUsed, text, toCopy);
+
+        arg.s.offset = stringBytesUsed;
+        arg.s.length = static_cast<uint8_t>(toCopy);
+        stringBytesUsed = static_cast<uint8_t>(stringBytesUsed + toCopy);
+    }
+};
+
+/** A log call as queued in memory: the format string is referenced by pointer. */
+struct LogRecord
+{
+    int64_t ticks = 0;
+    const char* format = nullptr;
+    LogCategory category = LogCategory::Init;
+    LogLevel level = LogLevel::Info;
+    LogArgs args;
+};
+
+/**
+ * Binary log file layout (little endian, native struct packing):
+ *
+ *   LogFile::Header
+ *   then a sequence of entries, each starting with a one byte LogFile::EntryType:
+ *     FormatString : uint32 formatId, uint16 length, <length> bytes of text
+ *     Record       : LogFile::Record
+ *
+ * A format string is written once, the first time a record refers to it.
+ */
+namespace LogFile
+{
+    constexpr char MAGIC[8] = { 'R', 'P', 'L', 'L', 'O', 'G', '0', '1' };
+    constexpr uint32_t VERSION = 1;
+
+    enum class EntryType : uint8_t
+    {
+        FormatString = 1,
+        Record = 2
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        int64_t startTimeMs;        // Wall-clock time (ms since epoch) at anchorTicks
+        int64_t anchorTicks;
+        int64_t ticksPerSecond;
+    };
+
+    struct Record
+    {
+        int64_t ticks;
+        uint32_t formatId;
+        LogCategory category;
+        LogLevel level;
+        uint16_t reserved;
+        LogArgs args;
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Fixed-capacity map that evicts the least recently used entry.
+ *
+ * Lookups and insertions are O(1): entries live in a list ordered from most
+ * to least recently used, indexed by a hash map. Not thread-safe; the owner
+ * provides any locking.
+ *
+ * @tparam Key   Key type, must be equality comparable
+ * @tparam Value Value type, copied out by find(); use a shared_ptr for large values
+ * @tparam Hash  Hash function object for Key
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache
+{
+public:
+    explicit LruCache(size_t maxEntries) : capacity(maxEntries) {}
+
+    /** The cached value, or nullptr. A hit makes the entry the most recently used. */
+    const Value* find(const Key& key)
+    {
+        const auto found = index.find(key);
+        if (found == index.end())
+            return nullptr;
+
+        entries.splice(entries.begin(), entries, found->second);
+        return &found->second->second;
+    }
+
+    /** Add or replace an entry, evicting the least recently used one if full. */
+    void insert(const Key& key, Value value)
+    {
+        if (capacity == 0)
+            return;
+
+        if (const auto found = index.find(key); found != index.end())
+        {
+            found->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, found->second);
+            return;
+        }
+
+        if (entries.size() >= capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+
+        entries.emplace_front(key, std::move(value));
+        index.emplace(key, entries.begin());
+    }
+
+    void clear()
+    {
+        index.clear();
+        entries.clear();
+    }
+
+    size_t size() const noexcept { return entries.size(); }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    size_t capacity;
+    std::list<Entry> entries;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Bounded lock-free multi-producer / single-consumer ring of fixed-size items.
+ *
+ * Each slot carries a sequence number (Vyukov's bounded queue), so producers
+ * only contend on a single compare-and-swap of the enqueue position and never
+ * block. When the ring is full tryPush() fails instead of waiting, which makes
+ * it safe to call from the audio thread.
+ *
+ * @tparam T        A trivially copyable item type
+ * @tparam Capacity Number of slots, must be a power of two
+ */
+template <typename T, size_t Capacity>
+class MpscRing
+{
+public:
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "Items are copied with plain assignment");
+
+    MpscRing()
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /** Push an item from any thread. Returns false if the ring is full. */
+    bool tryPush(const T& item) noexcept
+    {
+        auto position = enqueuePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& slot = slots[position & MASK];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (difference == 0)
+            {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.item = item;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Pop the oldest item. Must only be called from the single consumer thread. */
+    bool tryPop(T& item) noexcept
+    {
+        auto& slot = slots[dequeuePosition & MASK];
+
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+            return false;
+
+        item = slot.item;
+        slot.sequence.store(dequeuePosition + Capacity, std::memory_order_release);
+        ++dequeuePosition;
+        return true;
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        T item {};
+    };
+
+    std::array<Slot, Capacity> slots;
+    alignas(CACHE_LINE) std::atomic<size_t> enqueuePosition { 0 };
+    alignas(CACHE_LINE) size_t dequeuePosition = 0;
+};
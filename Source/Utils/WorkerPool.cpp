@@ -0,0 +1,163 @@
+#include "WorkerPool.h"
+#include "../DebugLogger.h"
+#include <algorithm>
+#include <atomic>
+
+WorkerPool::WorkerPool()
+{
+    startWorkers();
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        const std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+
+    jobAvailable.notify_all();
+
+    for (auto& worker : workers)
+        worker->stopThread(2000);
+}
+
+void WorkerPool::startWorkers()
+{
+    // Leave a core for the host's own audio and message threads
+    const int numCpus = juce::jmax(1, juce::SystemStats::getNumCpus());
+    const int numWorkers = juce::jlimit(1, MAX_WORKERS, numCpus - 1);
+
+    RIPPLE_LOG(Init, Info, "Starting {} shared workers on {} cores", numWorkers, numCpus);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>(*this, i);
+
+        // One core each, skipping core 0; more workers than cores are left unpinned
+        const int core = i + 1;
+        if (core < numCpus && core < 32)
+            worker->setAffinityMask(1u << core);
+
+        worker->startThread(juce::Thread::Priority::low);
+
+        workers.push_back(std::move(worker));
+    }
+}
+
+bool WorkerPool::hasJob() const
+{
+    return std::any_of(queues.begin(), queues.end(), [](const auto& queue) { return !queue.empty(); });
+}
+
+void WorkerPool::runJobs()
+{
+    std::unique_lock<std::mutex> guard(lock);
+
+    for (;;)
+    {
+        jobAvailable.wait(guard, [this] { return stopping || hasJob(); });
+
+        if (stopping)
+            return;
+
+        // Highest class first
+        auto queue = std::find_if(queues.begin(), queues.end(), [](const auto& q) { return !q.empty(); });
+
+        Job job = std::move(queue->front());
+        queue->pop_front();
+
+        --job.group->queued;
+        ++job.group->running;
+
+        guard.unlock();
+        job.function();
+        job.function = nullptr;     // release captures outside the lock
+        guard.lock();
+
+        --job.group->running;
+        jobFinished.notify_all();
+    }
+}
+
+void WorkerPool::parallelFor(Priority priority, int numItems, const std::function<void(int)>& function)
+{
+    if (numItems <= 1)
+    {
+        if (numItems == 1)
+            function(0);
+        return;
+    }
+
+    std::atomic<int> nextItem { 0 };
+    const auto runItems = [&nextItem, numItems, &function]
+    {
+        for (int item = nextItem++; item < numItems; item = nextItem++)
+            function(item);
+    };
+
+    // More helpers than workers would only queue behind each other
+    JobGroup helpers(priority);
+    const int numHelpers = juce::jmin(numItems - 1, helpers.getNumWorkers());
+    for (int i = 0; i < numHelpers; ++i)
+        helpers.submit(runItems);
+
+    runItems();
+
+    // Helpers that never started have nothing left to claim
+    helpers.cancelPending();
+    helpers.waitForAll();
+}
+
+//==============================================================================
+WorkerPool::Worker::Worker(WorkerPool& poolToUse, int index)
+    : juce::Thread("Rippleator Worker " + juce::String(index)),
+      pool(poolToUse)
+{
+}
+
+void WorkerPool::Worker::run()
+{
+    pool.runJobs();
+}
+
+//==============================================================================
+WorkerPool::JobGroup::JobGroup(Priority priorityToUse)
+    : priority(priorityToUse)
+{
+}
+
+WorkerPool::JobGroup::~JobGroup()
+{
+    cancelPending();
+    waitForAll();
+}
+
+void WorkerPool::JobGroup::submit(std::function<void()> job)
+{
+    {
+        const std::lock_guard<std::mutex> guard(pool->lock);
+
+        pool->queues[static_cast<size_t>(priority)].push_back({ std::move(job), &state });
+        ++state.queued;
+    }
+
+    pool->jobAvailable.notify_one();
+}
+
+void WorkerPool::JobGroup::cancelPending()
+{
+    const std::lock_guard<std::mutex> guard(pool->lock);
+
+    auto& queue = pool->queues[static_cast<size_t>(priority)];
+    queue.erase(std::remove_if(queue.begin(), queue.end(), [this](const Job& job) { return job.group == &state; }),
+                queue.end());
+    state.queued = 0;
+
+    pool->jobFinished.notify_all();
+}
+
+void WorkerPool::JobGroup::waitForAll()
+{
+    std::unique_lock<std::mutex> guard(pool->lock);
+    pool->jobFinished.wait(guard, [this] { return state.queued == 0 && state.running == 0; });
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Process-wide pool of worker threads, shared by every plugin instance
+ * through a juce::SharedResourcePointer, so that background work does not
+ * oversubscribe the machine however many instances are loaded.
+ *
+ * Jobs run in priority class order, then in submission order. The number
+ * of workers is bounded by the core count and each is pinned to its own
+ * core. Work the audio callback waits on does not come here: it runs on the
+ * BlockFanOut helpers, which never queue behind a trace.
+ *
+ * Clients submit through a JobGroup, which drops its queued jobs and waits
+ * for its running ones when destroyed, so a job may safely refer to its owner.
+ */
+class WorkerPool
+{
+public:
+    enum class Priority
+    {
+        interactive,    // Results the user is waiting to see, e.g. retraces
+        background      // Precomputation and baking
+    };
+
+    static constexpr int NUM_PRIORITIES = 2;
+    static constexpr int MAX_WORKERS = 16;
+
+    WorkerPool();
+    ~WorkerPool();
+
+    int getNumWorkers() const noexcept { return static_cast<int>(workers.size()); }
+
+    /**
+     * Call function(i) for every i in 0..numItems-1, on idle workers and on
+     * the calling thread, and return when all have finished. At most one
+     * helper job per worker is queued. The caller claims items like any
+     * worker, so this may be called from inside a job without waiting on
+     * workers that are busy elsewhere.
+     */
+    static void parallelFor(Priority priority, int numItems, const std::function<void(int)>& function);
+
+private:
+    /** Jobs of one group, counted under the pool lock. */
+    struct GroupState
+    {
+        int queued = 0;
+        int running = 0;
+    };
+
+public:
+    /** Jobs of one client at one priority. Not copyable; submit from any thread. */
+    class JobGroup
+    {
+    public:
+        explicit JobGroup(Priority priority);
+        ~JobGroup();
+
+        void submit(std::function<void()> job);
+
+        /** Drop the jobs that have not started yet. */
+        void cancelPending();
+
+        /** Block until none of this group's jobs is queued or running. */
+        void waitForAll();
+
+        int getNumWorkers() const noexcept { return pool->getNumWorkers(); }
+
+    private:
+        juce::SharedResourcePointer<WorkerPool> pool;
+        Priority priority;
+        GroupState state;
+
+        JUCE_DECLARE_NON_COPYABLE(JobGroup)
+    };
+
+private:
+    struct Job
+    {
+        std::function<void()> function;
+        GroupState* group = nullptr;
+    };
+
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(WorkerPool& pool, int index);
+        void run() override;
+
+    private:
+        WorkerPool& pool;
+    };
+
+    void startWorkers();
+    void runJobs();
+    bool hasJob() const;
+
+    std::mutex lock;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+    std::array<std::deque<Job>, NUM_PRIORITIES> queues;
+    bool stopping = false;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkerPool)
+};
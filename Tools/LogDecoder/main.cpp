@@ -0,0 +1,119 @@
+/**
+ * Offline decoder for the binary .rlog files written by DebugLogger.
+ *
+ * Usage: RippleatorLogDecoder <input.rlog> [output.txt]
+ * Writes one text line per record, in the same layout the old text log used:
+ *     [HH:MM:SS.mmm] [CATEGORY] LEVEL: message
+ */
+
+#include "Utils/LogFormat.h"
+
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+    std::string formatTimestamp(const LogFile::Header& header, int64_t ticks)
+    {
+        const double offsetSeconds = header.ticksPerSecond > 0
+            ? static_cast<double>(ticks - header.anchorTicks) / static_cast<double>(header.ticksPerSecond)
+            : 0.0;
+        const int64_t timeMs = header.startTimeMs + static_cast<int64_t>(offsetSeconds * 1000.0);
+
+        const std::time_t seconds = static_cast<std::time_t>(timeMs / 1000);
+        std::ostringstream timestamp;
+        timestamp << std::put_time(std::localtime(&seconds), "%H:%M:%S.")
+                  << std::setfill('0') << std::setw(3) << (timeMs % 1000);
+        return timestamp.str();
+    }
+
+    bool decode(std::istream& input, std::ostream& output)
+    {
+        LogFile::Header header {};
+        if (!input.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || !std::equal(std::begin(LogFile::MAGIC), std::end(LogFile::MAGIC), header.magic))
+        {
+            std::cerr << "Not a Rippleator binary log file" << std::endl;
+            return false;
+        }
+
+        if (header.version != LogFile::VERSION || header.recordSize != sizeof(LogFile::Record))
+        {
+            std::cerr << "Unsupported log file version " << header.version
+                      << " (record size " << header.recordSize << ")" << std::endl;
+            return false;
+        }
+
+        std::unordered_map<uint32_t, std::string> formats;
+        char entryType = 0;
+
+        while (input.get(entryType))
+        {
+            if (entryType == static_cast<char>(LogFile::EntryType::FormatString))
+            {
+                uint32_t id = 0;
+                uint16_t length = 0;
+                input.read(reinterpret_cast<char*>(&id), sizeof(id));
+                input.read(reinterpret_cast<char*>(&length), sizeof(length));
+
+                std::string text(length, '\0');
+                input.read(text.data(), length);
+                formats[id] = std::move(text);
+            }
+            else if (entryType == static_cast<char>(LogFile::EntryType::Record))
+            {
+                LogFile::Record record {};
+                if (!input.read(reinterpret_cast<char*>(&record), sizeof(record)))
+                    break;
+
+                auto format = formats.find(record.formatId);
+                const std::string message = format != formats.end()
+                    ? record.args.format(format->second.c_str())
+                    : "<unknown format " + std::to_string(record.formatId) + ">";
+
+                output << "[" << formatTimestamp(header, record.ticks) << "] "
+                       << "[" << getLogCategoryName(record.category) << "] ";
+
+                if (record.level >= LogLevel::Warning)
+                    output << getLogLevelName(record.level) << ": ";
+
+                output << message << "\n";
+            }
+            else
+            {
+                std::cerr << "Corrupt entry at offset " << static_cast<long long>(input.tellg()) - 1 << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.rlog> [output.txt]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input)
+    {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (argc > 2)
+    {
+        std::ofstream output(argv[2]);
+        return decode(input, output) ? 0 : 1;
+    }
+
+    return decode(input, std::cout) ? 0 : 1;
+}